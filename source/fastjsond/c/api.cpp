@@ -8,7 +8,38 @@
 #include "simdjson.h"
 
 #include <new>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cctype>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
 #include <cstring>
+#include <deque>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#if !defined(FASTJSOND_NO_SDT) && defined(__has_include)
+#if __has_include(<sys/sdt.h>)
+#define FJ_SDT 1
+#define _SDT_HAS_SEMAPHORES 1
+#include <sys/sdt.h>
+#endif
+#endif
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
 
 using namespace simdjson;
 
@@ -18,6 +49,10 @@ using namespace simdjson;
 
 struct fj_parser_s {
     dom::parser parser;
+    bool profiling = false;
+    bool borrow_strings = false;
+    bool profiled = false;              /* profile holds a parse */
+    fj_parse_profile profile;
     
     fj_parser_s(size_t max_capacity) {
         if (max_capacity > 0) {
@@ -29,8 +64,68 @@ struct fj_parser_s {
 struct fj_document_s {
     dom::element root;
     fj_error error;
+    uint64_t id;                        /* Unique per document, for field slot caches */
+    fj_parser_s* parser;                /* Owner of the tape and structural index */
+    const char* source;                 /* Parsed input (past any BOM), or null */
+    size_t source_len;
+    std::vector<uint32_t> source_map;   /* Tape index -> input offset, built on demand */
+    std::once_flag source_map_once;     /* Readers may share the document */
+    bool borrow_strings;                /* Hand out escape-free strings from source */
+    
+    fj_document_s() : error(FJ_SUCCESS), id(next_id()), parser(nullptr), source(nullptr),
+                      source_len(0), borrow_strings(false) {}
+
+    static uint64_t next_id() {
+        static std::atomic<uint64_t> counter{0};
+        return counter.fetch_add(1, std::memory_order_relaxed) + 1;
+    }
+};
+
+struct fj_stream_s {
+    std::unique_ptr<char[]> owned;      /* Padded copy of unpadded input */
+    dom::document_stream docs;
+    dom::document_stream::iterator it;
+    dom::element current;
+    bool started;
+    bool finished;
+    
+    /* Tolerant mode: batches are driven here instead of by docs */
+    bool tolerant;
+    fj_parser_s* parser;
+    const char* buf;
+    size_t len;
+    size_t batch_size;
+    size_t window;                      /* Bytes indexed by the next batch */
+    size_t batch_start;                 /* Input offset of the indexed batch */
+    size_t batch_next;                  /* Input offset of the batch after it */
+    bool batch_final;
+    bool batch_loaded;
+    size_t lines_pos;                   /* Line-by-line fallback cursor ... */
+    size_t lines_end;                   /* ... and end (equal when off) */
+    size_t last_resync;
+    size_t doc_offset;
+    size_t truncated;
+    size_t rejected;
+    fj_record_error_callback on_reject;
+    void* on_reject_ctx;
+    std::deque<fj_rejected_record> dead_letters;
     
-    fj_document_s() : error(FJ_SUCCESS) {}
+    fj_stream_s() : started(false), finished(false), tolerant(false), parser(nullptr),
+                    buf(nullptr), len(0), batch_size(0), window(0), batch_start(0),
+                    batch_next(0), batch_final(false), batch_loaded(false), lines_pos(0),
+                    lines_end(0), last_resync(0), doc_offset(0), truncated(0), rejected(0),
+                    on_reject(nullptr), on_reject_ctx(nullptr) {}
+};
+
+struct fj_path_segment {
+    enum kind_t : uint8_t { KEY, INDEX, KEY_OR_INDEX } kind;
+    size_t index;
+    fj_key key;                         /* Name points into fj_path_s::names */
+};
+
+struct fj_path_s {
+    std::vector<std::string> names;
+    std::vector<fj_path_segment> segments;
 };
 
 struct fj_array_iter_s {
@@ -38,7 +133,9 @@ struct fj_array_iter_s {
     dom::array::iterator current;
     dom::array::iterator end;
     
-    fj_array_iter_s(dom::array arr) : array(arr) {
+    void* doc;
+    
+    fj_array_iter_s(dom::array arr, void* d) : array(arr), doc(d) {
         current = array.begin();
         end = array.end();
     }
@@ -49,7 +146,9 @@ struct fj_object_iter_s {
     dom::object::iterator current;
     dom::object::iterator end;
     
-    fj_object_iter_s(dom::object obj) : object(obj) {
+    void* doc;
+    
+    fj_object_iter_s(dom::object obj, void* d) : object(obj), doc(d) {
         current = object.begin();
         end = object.end();
     }
@@ -111,386 +210,4305 @@ static fj_type map_type(dom::element_type t) {
 }
 
 /* ============================================================================
- * Parser Functions
+ * Tracing
  * ============================================================================ */
 
-extern "C" {
+/*
+ * USDT probes (provider "fastjsond") for perf and bpftrace, compiled in when
+ * <sys/sdt.h> is available unless -DFASTJSOND_NO_SDT is given. A probe site
+ * is a single nop until a tracer attaches. Arguments that cost something to
+ * produce (the parse duration, the split stage 1 / stage 2 parse) are only
+ * computed while the probe's semaphore says a tracer is listening.
+ *
+ *   parse__start      (json, len)
+ *   parse__done       (len, error, duration_ns)
+ *   parse__stage1     (len, structurals, error)
+ *   parse__stage2     (len, error)
+ *   parser__grow      (old_capacity, new_capacity)
+ *   stream__open      (len, batch_size)
+ *   stream__batch     (offset, len, error)
+ *   field__cache_miss (key, key_len)
+ */
+#if defined(FJ_SDT)
 
-fj_parser fj_parser_new(size_t max_capacity) {
-    try {
-        return new fj_parser_s(max_capacity);
-    } catch (...) {
-        return nullptr;
-    }
-}
+#define FJ_PROBE_SEMAPHORE(name) \
+    __extension__ volatile unsigned short fastjsond_##name##_semaphore \
+        __attribute__((unused)) __attribute__((section(".probes")))
 
-void fj_parser_free(fj_parser p) {
-    delete p;
+FJ_PROBE_SEMAPHORE(parse__start);
+FJ_PROBE_SEMAPHORE(parse__done);
+FJ_PROBE_SEMAPHORE(parse__stage1);
+FJ_PROBE_SEMAPHORE(parse__stage2);
+FJ_PROBE_SEMAPHORE(parser__grow);
+FJ_PROBE_SEMAPHORE(stream__open);
+FJ_PROBE_SEMAPHORE(stream__batch);
+FJ_PROBE_SEMAPHORE(field__cache_miss);
+
+#define FJ_PROBE_ENABLED(name) __builtin_expect(fastjsond_##name##_semaphore != 0, 0)
+#define FJ_PROBE2(name, a, b) DTRACE_PROBE2(fastjsond, name, a, b)
+#define FJ_PROBE3(name, a, b, c) DTRACE_PROBE3(fastjsond, name, a, b, c)
+
+#else
+
+#define FJ_PROBE_ENABLED(name) false
+#define FJ_PROBE2(name, a, b) ((void)sizeof(a), (void)sizeof(b))
+#define FJ_PROBE3(name, a, b, c) ((void)sizeof(a), (void)sizeof(b), (void)sizeof(c))
+
+#endif
+
+static inline uint64_t monotonic_ns() {
+    return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
 }
 
-fj_error fj_parser_parse(fj_parser p, const char* json, size_t len, fj_document* doc) {
-    if (!p || !json || !doc) {
-        return FJ_ERROR_UNINITIALIZED;
-    }
-    
-    try {
-        auto result = p->parser.parse(json, len);
-        if (result.error()) {
-            *doc = nullptr;
-            return map_error(result.error());
+/* Decoded bytes of every string (keys included) on a tape */
+static uint64_t tape_string_bytes(const dom::document& doc) {
+    const uint64_t* tape = doc.tape.get();
+    const size_t end = size_t(tape[0] & internal::JSON_VALUE_MASK);
+    uint64_t bytes = 0;
+    for (size_t i = 1; i < end; i++) {
+        auto type = internal::tape_type(tape[i] >> 56);
+        if (type == internal::tape_type::STRING) {
+            uint32_t len;
+            std::memcpy(&len, doc.string_buf.get() + (tape[i] & internal::JSON_VALUE_MASK), sizeof(len));
+            bytes += len;
+        } else if (type == internal::tape_type::INT64 || type == internal::tape_type::UINT64 ||
+                   type == internal::tape_type::DOUBLE) {
+            i++;
         }
-        
-        auto d = new fj_document_s();
-        d->root = result.value();
-        d->error = FJ_SUCCESS;
-        *doc = d;
-        return FJ_SUCCESS;
-    } catch (...) {
-        *doc = nullptr;
-        return FJ_ERROR_UNEXPECTED_ERROR;
     }
+    return bytes;
 }
 
-fj_error fj_parser_parse_padded(fj_parser p, const char* json, size_t len, fj_document* doc) {
-    /* For padded input, simdjson can skip the copy */
-    return fj_parser_parse(p, json, len, doc);
+/*
+ * parser.parse() with stage 1 and stage 2 run separately so that the
+ * boundary can be probed and timed. Only taken while a stage probe is
+ * attached or the parser is profiling: it always copies the input, which
+ * parse() avoids for padded input.
+ */
+static simdjson_result<dom::element> parse_staged(dom::parser& parser, const char* json, size_t len,
+                                                  fj_parse_profile* profile) {
+    if (profile) *profile = fj_parse_profile();
+    /* As parser::ensure_capacity (private) */
+    size_t capacity = std::max(len, dom::MINIMAL_DOCUMENT_CAPACITY);
+    if (capacity > parser.max_capacity()) return CAPACITY;
+    if (parser.doc.capacity() < capacity) {
+        error_code err = parser.doc.allocate(capacity);
+        if (err) return err;
+    }
+    if (parser.capacity() < capacity) {
+        error_code err = parser.allocate(capacity, parser.max_depth());
+        if (err) return err;
+    }
+    std::unique_ptr<uint8_t[]> buf(new uint8_t[len + SIMDJSON_PADDING]);
+    std::memcpy(buf.get(), json, len);
+    std::memset(buf.get() + len, 0, SIMDJSON_PADDING);
+
+    const uint8_t* start = buf.get();
+    size_t n = len;
+    if (n >= 3 && std::memcmp(start, "\xEF\xBB\xBF", 3) == 0) {
+        start += 3;
+        n -= 3;
+    }
+    internal::dom_parser_implementation& impl = *parser.implementation;
+    uint64_t t0 = profile ? monotonic_ns() : 0;
+    error_code err = impl.stage1(start, n, stage1_mode::regular);
+    uint64_t t1 = profile ? monotonic_ns() : 0;
+    FJ_PROBE3(parse__stage1, n, size_t(impl.n_structural_indexes), int(err));
+    if (profile) {
+        profile->stage1_ns = t1 - t0;
+        profile->structurals = impl.n_structural_indexes;
+    }
+    if (err) return err;
+    err = impl.stage2(parser.doc);
+    FJ_PROBE2(parse__stage2, n, int(err));
+    if (profile) profile->stage2_ns = monotonic_ns() - t1;
+    if (err) return err;
+    if (profile) profile->string_bytes = tape_string_bytes(parser.doc);
+    return parser.doc.root();
 }
 
 /* ============================================================================
- * Document Functions
+ * Metrics
  * ============================================================================ */
 
-void fj_document_free(fj_document doc) {
-    delete doc;
+/*
+ * Process-wide counters, compiled in with -DFASTJSOND_METRICS. Each thread
+ * updates its own cache-line-aligned shard with relaxed atomics, so parsers
+ * never take a lock or share a line on the hot path; fj_metrics_render sums
+ * the shards. Without the flag every hook below is an empty inline function.
+ */
+#if defined(FASTJSOND_METRICS)
+
+static const size_t METRICS_SHARDS = 16;
+static const size_t METRICS_ERROR_SLOTS = FJ_ERROR_UNCLOSED_COMMENT + 2;   /* Last slot: unknown */
+
+/* Parse latency histogram, per input size class */
+static const size_t METRICS_SIZE_CLASSES = 5;
+static const uint64_t METRICS_SIZE_BOUNDS[METRICS_SIZE_CLASSES - 1] = {
+    uint64_t(1) << 10, uint64_t(1) << 16, uint64_t(1) << 20, uint64_t(1) << 24
+};
+static const char* const METRICS_SIZE_LABELS[METRICS_SIZE_CLASSES] = {
+    "1KiB", "64KiB", "1MiB", "16MiB", "larger"
+};
+static const size_t METRICS_LATENCY_BUCKETS = 8;
+static const uint64_t METRICS_LATENCY_BOUNDS_NS[METRICS_LATENCY_BUCKETS] = {
+    1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000, 10000000000
+};
+static const char* const METRICS_LATENCY_LABELS[METRICS_LATENCY_BUCKETS] = {
+    "1e-06", "1e-05", "0.0001", "0.001", "0.01", "0.1", "1", "10"
+};
+
+struct alignas(64) metrics_shard {
+    std::atomic<uint64_t> parses;
+    std::atomic<uint64_t> parse_bytes;
+    std::atomic<uint64_t> latency[METRICS_SIZE_CLASSES][METRICS_LATENCY_BUCKETS + 1];   /* Not cumulative */
+    std::atomic<uint64_t> latency_sum_ns[METRICS_SIZE_CLASSES];
+    std::atomic<uint64_t> errors[METRICS_ERROR_SLOTS];
+    std::atomic<uint64_t> streams;
+    std::atomic<uint64_t> stream_bytes;
+    std::atomic<uint64_t> stream_documents;
+    std::atomic<uint64_t> stream_rejected;
+    std::atomic<uint64_t> field_cache_hits;
+    std::atomic<uint64_t> field_cache_misses;
+};
+
+static metrics_shard metrics_shards[METRICS_SHARDS];
+
+static inline metrics_shard& metrics_local() {
+    static std::atomic<size_t> next_shard{0};
+    static thread_local metrics_shard* shard =
+        &metrics_shards[next_shard.fetch_add(1, std::memory_order_relaxed) % METRICS_SHARDS];
+    return *shard;
 }
 
-fj_value fj_document_root(fj_document doc) {
-    fj_value v;
-    v.impl = doc ? reinterpret_cast<void*>(&doc->root) : nullptr;
-    v.doc = doc;
-    return v;
+static inline void metrics_add(std::atomic<uint64_t>& counter, uint64_t n) {
+    counter.fetch_add(n, std::memory_order_relaxed);
 }
 
-fj_error fj_document_error(fj_document doc) {
-    return doc ? doc->error : FJ_ERROR_UNINITIALIZED;
+static inline void metrics_error(metrics_shard& m, fj_error err) {
+    size_t slot = size_t(err) < METRICS_ERROR_SLOTS - 1 ? size_t(err) : METRICS_ERROR_SLOTS - 1;
+    metrics_add(m.errors[slot], 1);
 }
 
-const char* fj_error_message(fj_error err) {
-    static const char* messages[] = {
-        "Success",
-        "Document too large",
-        "Memory allocation failed",
-        "Internal tape error",
-        "Document too deep",
-        "Invalid string",
-        "Invalid 'true' atom",
-        "Invalid 'false' atom",
-        "Invalid 'null' atom",
-        "Invalid number",
-        "Invalid UTF-8 encoding",
-        "Parser not initialized",
-        "Empty input",
-        "Unescaped control characters in string",
-        "Unclosed string",
-        "Unsupported architecture",
-        "Incorrect type",
-        "Number out of range",
-        "Array index out of bounds",
-        "Object field not found",
-        "I/O error",
-        "Invalid JSON pointer",
-        "Invalid URI fragment",
-        "Unexpected error",
-        "Parser already in use",
-        "Out of order iteration",
-        "Insufficient padding",
-        "Incomplete array or object",
-        "Scalar document as value",
-        "Out of bounds",
-        "Trailing content after JSON"
-    };
-    
-    if (err == FJ_ERROR_UNKNOWN || err > FJ_ERROR_TRAILING_CONTENT) {
-        return "Unknown error";
+static inline void metrics_parse_done(uint64_t ns, size_t len, fj_error err) {
+    size_t size_class = 0;
+    while (size_class < METRICS_SIZE_CLASSES - 1 && len > METRICS_SIZE_BOUNDS[size_class]) size_class++;
+    size_t bucket = 0;
+    while (bucket < METRICS_LATENCY_BUCKETS && ns > METRICS_LATENCY_BOUNDS_NS[bucket]) bucket++;
+
+    metrics_shard& m = metrics_local();
+    metrics_add(m.parses, 1);
+    metrics_add(m.parse_bytes, len);
+    metrics_add(m.latency[size_class][bucket], 1);
+    metrics_add(m.latency_sum_ns[size_class], ns);
+    if (err != FJ_SUCCESS) metrics_error(m, err);
+}
+
+static inline void metrics_stream_open(size_t len) {
+    metrics_shard& m = metrics_local();
+    metrics_add(m.streams, 1);
+    metrics_add(m.stream_bytes, len);
+}
+
+static inline void metrics_stream_document() { metrics_add(metrics_local().stream_documents, 1); }
+static inline void metrics_stream_error(fj_error err) { metrics_error(metrics_local(), err); }
+static inline void metrics_stream_rejected() { metrics_add(metrics_local().stream_rejected, 1); }
+
+static inline void metrics_field_cache(bool hit) {
+    metrics_shard& m = metrics_local();
+    metrics_add(hit ? m.field_cache_hits : m.field_cache_misses, 1);
+}
+
+/* Label of each error code in fastjsond_errors_total */
+static const char* const METRICS_ERROR_NAMES[METRICS_ERROR_SLOTS] = {
+    "success", "capacity", "memalloc", "tape_error", "depth_error", "string_error",
+    "t_atom_error", "f_atom_error", "n_atom_error", "number_error", "utf8_error",
+    "uninitialized", "empty", "unescaped_chars", "unclosed_string", "unsupported_arch",
+    "incorrect_type", "number_out_of_range", "index_out_of_bounds", "no_such_field",
+    "io_error", "invalid_json_pointer", "invalid_uri_fragment", "unexpected_error",
+    "parser_in_use", "out_of_order_iteration", "insufficient_padding",
+    "incomplete_array_or_object", "scalar_document_as_value", "out_of_bounds",
+    "trailing_content", "invalid_patch", "patch_test_failed", "invalid_timestamp",
+    "invalid_encoding", "unclosed_comment", "unknown"
+};
+
+static uint64_t metrics_sum(std::atomic<uint64_t> metrics_shard::*field) {
+    uint64_t total = 0;
+    for (const metrics_shard& m : metrics_shards) total += (m.*field).load(std::memory_order_relaxed);
+    return total;
+}
+
+template <typename F>
+static uint64_t metrics_sum_each(F&& field) {
+    uint64_t total = 0;
+    for (metrics_shard& m : metrics_shards) total += field(m).load(std::memory_order_relaxed);
+    return total;
+}
+
+static void metrics_counter(std::string& out, const char* name, const char* help, uint64_t value) {
+    char line[64];
+    out += "# HELP "; out += name; out += ' '; out += help; out += '\n';
+    out += "# TYPE "; out += name; out += " counter\n";
+    std::snprintf(line, sizeof(line), " %llu\n", static_cast<unsigned long long>(value));
+    out += name; out += line;
+}
+
+static std::string metrics_render() {
+    std::string out;
+    char line[160];
+
+    metrics_counter(out, "fastjsond_parse_total", "Documents parsed.",
+                    metrics_sum(&metrics_shard::parses));
+    metrics_counter(out, "fastjsond_parse_bytes_total", "Bytes of JSON parsed (rate() gives throughput).",
+                    metrics_sum(&metrics_shard::parse_bytes));
+
+    out += "# HELP fastjsond_parse_duration_seconds Parse latency by input size class (upper bound).\n";
+    out += "# TYPE fastjsond_parse_duration_seconds histogram\n";
+    for (size_t c = 0; c < METRICS_SIZE_CLASSES; c++) {
+        uint64_t cumulative = 0;
+        for (size_t b = 0; b <= METRICS_LATENCY_BUCKETS; b++) {
+            cumulative += metrics_sum_each([&](metrics_shard& m) -> std::atomic<uint64_t>& {
+                return m.latency[c][b];
+            });
+            std::snprintf(line, sizeof(line),
+                          "fastjsond_parse_duration_seconds_bucket{size=\"%s\",le=\"%s\"} %llu\n",
+                          METRICS_SIZE_LABELS[c],
+                          b < METRICS_LATENCY_BUCKETS ? METRICS_LATENCY_LABELS[b] : "+Inf",
+                          static_cast<unsigned long long>(cumulative));
+            out += line;
+        }
+        uint64_t sum_ns = metrics_sum_each([&](metrics_shard& m) -> std::atomic<uint64_t>& {
+            return m.latency_sum_ns[c];
+        });
+        std::snprintf(line, sizeof(line), "fastjsond_parse_duration_seconds_sum{size=\"%s\"} %.9f\n",
+                      METRICS_SIZE_LABELS[c], double(sum_ns) / 1e9);
+        out += line;
+        std::snprintf(line, sizeof(line), "fastjsond_parse_duration_seconds_count{size=\"%s\"} %llu\n",
+                      METRICS_SIZE_LABELS[c], static_cast<unsigned long long>(cumulative));
+        out += line;
     }
-    return messages[err];
+
+    out += "# HELP fastjsond_errors_total Parse and stream errors by code.\n";
+    out += "# TYPE fastjsond_errors_total counter\n";
+    for (size_t e = 1; e < METRICS_ERROR_SLOTS; e++) {
+        uint64_t n = metrics_sum_each([&](metrics_shard& m) -> std::atomic<uint64_t>& {
+            return m.errors[e];
+        });
+        if (n == 0) continue;
+        std::snprintf(line, sizeof(line), "fastjsond_errors_total{code=\"%s\"} %llu\n",
+                      METRICS_ERROR_NAMES[e], static_cast<unsigned long long>(n));
+        out += line;
+    }
+
+    metrics_counter(out, "fastjsond_streams_total", "Document streams opened.",
+                    metrics_sum(&metrics_shard::streams));
+    metrics_counter(out, "fastjsond_stream_bytes_total", "Bytes of input handed to document streams.",
+                    metrics_sum(&metrics_shard::stream_bytes));
+    metrics_counter(out, "fastjsond_stream_documents_total", "Documents delivered by streams.",
+                    metrics_sum(&metrics_shard::stream_documents));
+    metrics_counter(out, "fastjsond_stream_rejected_total", "Malformed records skipped by tolerant streams.",
+                    metrics_sum(&metrics_shard::stream_rejected));
+    metrics_counter(out, "fastjsond_field_cache_hits_total", "Cached field lookups that hit the remembered slot.",
+                    metrics_sum(&metrics_shard::field_cache_hits));
+    metrics_counter(out, "fastjsond_field_cache_misses_total", "Cached field lookups that fell back to a scan.",
+                    metrics_sum(&metrics_shard::field_cache_misses));
+    return out;
 }
 
-/* ============================================================================
- * Value Type Functions
- * ============================================================================ */
+#else
 
-static inline dom::element* get_element(fj_value v) {
-    return reinterpret_cast<dom::element*>(v.impl);
+static inline void metrics_parse_done(uint64_t, size_t, fj_error) {}
+static inline void metrics_stream_open(size_t) {}
+static inline void metrics_stream_document() {}
+static inline void metrics_stream_error(fj_error) {}
+static inline void metrics_stream_rejected() {}
+static inline void metrics_field_cache(bool) {}
+
+#endif
+
+/* Start of a parse: the clock is read only if metrics or a tracer need it */
+static inline uint64_t parse_begin(const char* json, size_t len) {
+    FJ_PROBE2(parse__start, json, len);
+#if defined(FASTJSOND_METRICS)
+    return monotonic_ns();
+#else
+    return FJ_PROBE_ENABLED(parse__done) ? monotonic_ns() : 0;
+#endif
 }
 
-fj_type fj_value_type(fj_value v) {
-    if (!v.impl) return FJ_TYPE_NULL;
-    return map_type(get_element(v)->type());
+static inline void parse_end(uint64_t started, size_t len, fj_error err) {
+    uint64_t ns = started ? monotonic_ns() - started : 0;
+    metrics_parse_done(ns, len, err);
+    FJ_PROBE3(parse__done, len, int(err), ns);
 }
 
-bool fj_value_is_null(fj_value v) {
-    return v.impl && get_element(v)->is_null();
+/* ============================================================================
+ * Tape Helpers
+ * ============================================================================ */
+
+/*
+ * dom::element is a thin (document*, tape index) pair, but simdjson keeps the
+ * pair private. Walking the tape directly lets us skip whole subtrees in one
+ * hop, so we read and rebuild elements through the public tape_ref layout.
+ */
+static_assert(sizeof(dom::element) == sizeof(internal::tape_ref),
+              "dom::element layout no longer matches internal::tape_ref");
+
+static inline internal::tape_ref tape_of(const dom::element* e) {
+    internal::tape_ref t;
+    std::memcpy(static_cast<void*>(&t), static_cast<const void*>(e), sizeof(t));
+    return t;
 }
 
-bool fj_value_is_bool(fj_value v) {
-    return v.impl && get_element(v)->is_bool();
+static inline dom::element element_at(const dom::document* doc, size_t json_index) {
+    internal::tape_ref t(doc, json_index);
+    dom::element e;
+    std::memcpy(static_cast<void*>(&e), static_cast<const void*>(&t), sizeof(e));
+    return e;
 }
 
-bool fj_value_is_int64(fj_value v) {
-    return v.impl && get_element(v)->is_int64();
+static inline bool tape_key_equals(const internal::tape_ref& k, const char* key, size_t key_len) {
+    return k.get_string_length() == key_len &&
+           std::memcmp(k.get_c_str(), key, key_len) == 0;
 }
 
-bool fj_value_is_uint64(fj_value v) {
-    return v.impl && get_element(v)->is_uint64();
+/* Compare a tape key against a prepared key: length, then 16 bytes at once */
+static inline bool tape_key_matches(const internal::tape_ref& k, const fj_key* key) {
+    if (k.get_string_length() != key->len) return false;
+    /* The string buffer is padded, so reading 16 bytes past short keys is safe */
+    const char* s = k.get_c_str();
+    uint64_t w0, w1;
+    std::memcpy(&w0, s, sizeof(w0));
+    std::memcpy(&w1, s + 8, sizeof(w1));
+    if ((((w0 ^ key->prefix[0]) & key->mask[0]) | ((w1 ^ key->prefix[1]) & key->mask[1])) != 0) {
+        return false;
+    }
+    return key->len <= 16 || std::memcmp(s + 16, key->name + 16, key->len - 16) == 0;
 }
 
-bool fj_value_is_double(fj_value v) {
-    return v.impl && get_element(v)->is_double();
+/*
+ * Find a field through a slot cache. The key position remembered for the
+ * same object of the same document is checked with one compare; any other
+ * object first tries the remembered field ordinal, then scans. document is
+ * 0 when the tape has no fj_document (the position is then not cached).
+ * Returns the tape index of the field value, or 0 if absent (index 0 is the
+ * root header and never an element).
+ */
+template <typename Match>
+static size_t tape_find_cached(const internal::tape_ref& obj, uint64_t document, fj_field_slot* slot,
+                               const char* name, size_t len, const Match& matches) {
+    const size_t end = obj.matching_brace_index() - 1;
+
+    if (document && slot->document == document && slot->object == obj.json_index &&
+        slot->key > obj.json_index && slot->key < end && matches(internal::tape_ref(obj.doc, slot->key))) {
+        metrics_field_cache(true);
+        return size_t(slot->key) + 1;
+    }
+
+    size_t idx = obj.json_index + 1;
+    uint32_t ordinal = 0;
+    while (ordinal < slot->ordinal && idx < end) {
+        idx = internal::tape_ref(obj.doc, idx + 1).after_element();
+        ordinal++;
+    }
+    if (idx >= end || !matches(internal::tape_ref(obj.doc, idx))) {
+        metrics_field_cache(false);
+        FJ_PROBE2(field__cache_miss, name, len);
+        idx = obj.json_index + 1;
+        ordinal = 0;
+        while (idx < end && !matches(internal::tape_ref(obj.doc, idx))) {
+            idx = internal::tape_ref(obj.doc, idx + 1).after_element();
+            ordinal++;
+        }
+        if (idx >= end) return 0;
+        slot->ordinal = ordinal;
+    } else {
+        metrics_field_cache(true);
+    }
+    slot->document = document;
+    slot->object = uint32_t(obj.json_index);
+    slot->key = uint32_t(idx);
+    return idx + 1;
 }
 
-bool fj_value_is_number(fj_value v) {
-    if (!v.impl) return false;
-    auto t = get_element(v)->type();
-    return t == dom::element_type::INT64 || 
-           t == dom::element_type::UINT64 || 
-           t == dom::element_type::DOUBLE;
+/* Find a field by prepared key, through key->slot */
+static size_t tape_find_key(const internal::tape_ref& obj, uint64_t document, fj_key* key) {
+    return tape_find_cached(obj, document, &key->slot, key->name, key->len,
+                            [key](const internal::tape_ref& k) { return tape_key_matches(k, key); });
 }
 
-bool fj_value_is_string(fj_value v) {
-    return v.impl && get_element(v)->is_string();
+/* Tape index of array element n, or 0 if out of bounds */
+static size_t tape_find_index(const internal::tape_ref& arr, size_t n) {
+    const size_t end = arr.matching_brace_index() - 1;
+    size_t idx = arr.json_index + 1;
+    while (idx < end) {
+        if (n-- == 0) return idx;
+        idx = internal::tape_ref(arr.doc, idx).after_element();
+    }
+    return 0;
 }
 
-bool fj_value_is_array(fj_value v) {
-    return v.impl && get_element(v)->is_array();
+/* Tape index of the named member's value in the object at obj_idx, or 0 */
+static size_t tape_find_field(const dom::document* doc, size_t obj_idx, const char* key, size_t key_len) {
+    internal::tape_ref obj(doc, obj_idx);
+    if (obj.tape_ref_type() != internal::tape_type::START_OBJECT) return 0;
+    const size_t end = obj.matching_brace_index() - 1;
+    for (size_t k = obj_idx + 1; k < end; k = internal::tape_ref(doc, k + 1).after_element()) {
+        if (tape_key_equals(internal::tape_ref(doc, k), key, key_len)) return k + 1;
+    }
+    return 0;
 }
 
-bool fj_value_is_object(fj_value v) {
-    return v.impl && get_element(v)->is_object();
+/* Ring of elements backing fj_value handles returned by tape lookups */
+static inline dom::element* stash_element(const dom::element& e) {
+    static thread_local dom::element stored_elements[256];
+    static thread_local size_t stored_idx = 0;
+    stored_idx = (stored_idx + 1) % 256;
+    stored_elements[stored_idx] = e;
+    return &stored_elements[stored_idx];
 }
 
 /* ============================================================================
- * Value Extraction Functions
+ * Path Helpers
  * ============================================================================ */
 
-fj_error fj_value_get_bool(fj_value v, bool* out) {
-    if (!v.impl || !out) return FJ_ERROR_UNINITIALIZED;
-    
-    auto result = get_element(v)->get_bool();
-    if (result.error()) return map_error(result.error());
-    *out = result.value();
-    return FJ_SUCCESS;
+static bool path_is_index(const std::string& token) {
+    if (token.empty() || token.size() > 19) return false;
+    if (token.size() > 1 && token[0] == '0') return false;
+    for (char c : token) {
+        if (c < '0' || c > '9') return false;
+    }
+    return true;
 }
 
-fj_error fj_value_get_int64(fj_value v, int64_t* out) {
-    if (!v.impl || !out) return FJ_ERROR_UNINITIALIZED;
-    
-    auto result = get_element(v)->get_int64();
-    if (result.error()) return map_error(result.error());
-    *out = result.value();
-    return FJ_SUCCESS;
-}
+/*
+ * Compile "/a/0/b" (JSON Pointer) or ".a[0].b" (dotted, leading dot optional)
+ * into segments. Pointer tokens that look like indexes match either an array
+ * position or an object key, as in RFC 6901. The path must not move after
+ * this returns: segment keys point into path->names.
+ */
+static fj_error path_compile(const char* text, size_t len, fj_path_s* path) {
+    std::vector<fj_path_segment::kind_t> kinds;
+    size_t i = 0;
 
-fj_error fj_value_get_uint64(fj_value v, uint64_t* out) {
-    if (!v.impl || !out) return FJ_ERROR_UNINITIALIZED;
-    
-    auto result = get_element(v)->get_uint64();
-    if (result.error()) return map_error(result.error());
-    *out = result.value();
+    if (len > 0 && text[0] == '/') {
+        while (i < len) {
+            i++;    /* skip '/' */
+            std::string token;
+            while (i < len && text[i] != '/') {
+                if (text[i] == '~') {
+                    if (i + 1 >= len) return FJ_ERROR_INVALID_JSON_POINTER;
+                    if (text[i + 1] == '0') token += '~';
+                    else if (text[i + 1] == '1') token += '/';
+                    else return FJ_ERROR_INVALID_JSON_POINTER;
+                    i += 2;
+                } else {
+                    token += text[i++];
+                }
+            }
+            kinds.push_back(path_is_index(token) ? fj_path_segment::KEY_OR_INDEX
+                                                 : fj_path_segment::KEY);
+            path->names.push_back(std::move(token));
+        }
+    } else {
+        if (len > 0 && text[0] == '.') i++;
+        bool expect_name = i < len;
+        while (i < len) {
+            if (text[i] == '[') {
+                size_t close = i + 1;
+                while (close < len && text[close] != ']') close++;
+                std::string token(text + i + 1, close - i - 1);
+                if (close >= len || !path_is_index(token)) return FJ_ERROR_INVALID_JSON_POINTER;
+                kinds.push_back(fj_path_segment::INDEX);
+                path->names.push_back(std::move(token));
+                i = close + 1;
+                expect_name = false;
+            } else if (text[i] == '.') {
+                if (expect_name) return FJ_ERROR_INVALID_JSON_POINTER;
+                i++;
+                expect_name = true;
+                if (i >= len) return FJ_ERROR_INVALID_JSON_POINTER;
+            } else {
+                size_t start = i;
+                while (i < len && text[i] != '.' && text[i] != '[') i++;
+                kinds.push_back(fj_path_segment::KEY);
+                path->names.emplace_back(text + start, i - start);
+                expect_name = false;
+            }
+        }
+    }
+
+    path->segments.resize(kinds.size());
+    for (size_t s = 0; s < kinds.size(); s++) {
+        fj_path_segment& seg = path->segments[s];
+        const std::string& name = path->names[s];
+        seg.kind = kinds[s];
+        seg.index = kinds[s] == fj_path_segment::KEY ? 0 : std::stoull(name);
+        fj_key_init(&seg.key, name.data(), name.size());
+    }
     return FJ_SUCCESS;
 }
 
-fj_error fj_value_get_double(fj_value v, double* out) {
-    if (!v.impl || !out) return FJ_ERROR_UNINITIALIZED;
-    
-    auto result = get_element(v)->get_double();
-    if (result.error()) return map_error(result.error());
-    *out = result.value();
+/* Split a JSON Pointer (not a dotted path) into unescaped reference tokens */
+static fj_error pointer_split(const char* text, size_t len, std::vector<std::string>& tokens) {
+    if (len > 0 && text[0] != '/') return FJ_ERROR_INVALID_JSON_POINTER;
+    fj_path_s path;
+    fj_error err = path_compile(text, len, &path);
+    if (err != FJ_SUCCESS) return err;
+    tokens.swap(path.names);
     return FJ_SUCCESS;
 }
 
-fj_error fj_value_get_string(fj_value v, const char** out, size_t* len) {
-    if (!v.impl || !out || !len) return FJ_ERROR_UNINITIALIZED;
-    
-    auto result = get_element(v)->get_string();
-    if (result.error()) return map_error(result.error());
-    std::string_view sv = result.value();
-    *out = sv.data();
-    *len = sv.size();
+/*
+ * Follow a compiled path from tape index idx; *out receives the target
+ * index. document is the id of the fj_document owning doc (0 if none), so
+ * that re-walking the same document hits each step's slot directly.
+ */
+static fj_error path_walk(const dom::document* doc, uint64_t document, size_t idx,
+                          fj_path_s* path, size_t* out) {
+    for (fj_path_segment& seg : path->segments) {
+        internal::tape_ref t(doc, idx);
+        auto type = t.tape_ref_type();
+        if (type == internal::tape_type::START_OBJECT && seg.kind != fj_path_segment::INDEX) {
+            idx = tape_find_key(t, document, &seg.key);
+            if (idx == 0) return FJ_ERROR_NO_SUCH_FIELD;
+        } else if (type == internal::tape_type::START_ARRAY && seg.kind != fj_path_segment::KEY) {
+            idx = tape_find_index(t, seg.index);
+            if (idx == 0) return FJ_ERROR_INDEX_OUT_OF_BOUNDS;
+        } else {
+            return FJ_ERROR_INCORRECT_TYPE;
+        }
+    }
+    *out = idx;
     return FJ_SUCCESS;
 }
 
 /* ============================================================================
- * Object Access Functions
+ * Aggregation Helpers
  * ============================================================================ */
 
-fj_error fj_value_get_field(fj_value v, const char* key, fj_value* out) {
-    if (!v.impl || !key || !out) return FJ_ERROR_UNINITIALIZED;
-    
-    auto obj_result = get_element(v)->get_object();
-    if (obj_result.error()) return map_error(obj_result.error());
-    
-    auto field_result = obj_result.value()[key];
-    if (field_result.error()) return map_error(field_result.error());
+/* MurmurHash3 finalizer: spreads FNV-1a output over all 64 bits */
+static inline uint64_t fmix64(uint64_t h) {
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+static inline uint64_t hash_bytes(const char* data, size_t len, uint64_t seed) {
+    uint64_t h = 14695981039346656037ULL ^ seed;
+    for (size_t i = 0; i < len; i++) {
+        h ^= static_cast<unsigned char>(data[i]);
+        h *= 1099511628211ULL;
+    }
+    return fmix64(h);
+}
+
+/* HyperLogLog with 2^10 registers: ~3.2% standard error in 1 KiB per group */
+static constexpr unsigned HLL_BITS = 10;
+static constexpr size_t HLL_REGISTERS = size_t(1) << HLL_BITS;
+
+struct agg_group {
+    std::string key;
+    uint64_t hash;
+    uint64_t count;
+    uint64_t numeric_count;
+    double sum;
+    double min;
+    double max;
+    uint8_t hll[HLL_REGISTERS];
     
-    /* Store element in document's memory */
-    static thread_local dom::element stored_elements[256];
-    static thread_local size_t stored_idx = 0;
-    stored_idx = (stored_idx + 1) % 256;
-    stored_elements[stored_idx] = field_result.value();
+    agg_group(const char* k, size_t len, uint64_t h)
+        : key(k, len), hash(h), count(0), numeric_count(0), sum(0),
+          min(std::numeric_limits<double>::infinity()),
+          max(-std::numeric_limits<double>::infinity()) {
+        std::memset(hll, 0, sizeof(hll));
+    }
+};
+
+struct fj_agg_s {
+    fj_path_s value_path;
+    fj_path_s group_path;
+    bool grouped;
+    std::vector<std::unique_ptr<agg_group>> groups;   /* Insertion order */
+    std::vector<uint32_t> table;                      /* Group index + 1, 0 = empty */
+    uint64_t skipped;
     
-    out->impl = &stored_elements[stored_idx];
-    out->doc = v.doc;
-    return FJ_SUCCESS;
+    fj_agg_s() : grouped(false), skipped(0) {}
+};
+
+static inline void hll_add(uint8_t* registers, uint64_t h) {
+    size_t reg = h >> (64 - HLL_BITS);
+    uint64_t rest = (h << HLL_BITS) | (uint64_t(1) << (HLL_BITS - 1));
+    uint8_t rank = static_cast<uint8_t>(__builtin_clzll(rest) + 1);
+    if (rank > registers[reg]) registers[reg] = rank;
+}
+
+static uint64_t hll_estimate(const uint8_t* registers) {
+    const double m = static_cast<double>(HLL_REGISTERS);
+    double sum = 0;
+    size_t zeros = 0;
+    for (size_t i = 0; i < HLL_REGISTERS; i++) {
+        sum += std::ldexp(1.0, -registers[i]);
+        if (registers[i] == 0) zeros++;
+    }
+    double estimate = (0.7213 / (1.0 + 1.079 / m)) * m * m / sum;
+    if (estimate <= 2.5 * m && zeros > 0) {
+        estimate = m * std::log(m / static_cast<double>(zeros));   /* Linear counting */
+    }
+    return static_cast<uint64_t>(estimate + 0.5);
+}
+
+/* Find or create the group for key (open addressing, linear probing) */
+static agg_group* agg_find_group(fj_agg_s* agg, const char* key, size_t len) {
+    uint64_t h = hash_bytes(key, len, 0);
+    if ((agg->groups.size() + 1) * 4 > agg->table.size() * 3) {
+        size_t size = agg->table.empty() ? 16 : agg->table.size() * 2;
+        std::vector<uint32_t> table(size, 0);
+        for (size_t g = 0; g < agg->groups.size(); g++) {
+            size_t i = agg->groups[g]->hash & (size - 1);
+            while (table[i]) i = (i + 1) & (size - 1);
+            table[i] = static_cast<uint32_t>(g + 1);
+        }
+        agg->table.swap(table);
+    }
+    const size_t mask = agg->table.size() - 1;
+    size_t i = h & mask;
+    while (agg->table[i]) {
+        agg_group* g = agg->groups[agg->table[i] - 1].get();
+        if (g->hash == h && g->key.size() == len && std::memcmp(g->key.data(), key, len) == 0) {
+            return g;
+        }
+        i = (i + 1) & mask;
+    }
+    agg->groups.emplace_back(new agg_group(key, len, h));
+    agg->table[i] = static_cast<uint32_t>(agg->groups.size());
+    return agg->groups.back().get();
+}
+
+/* Fold one document (rooted at tape index root) into the aggregate */
+static void agg_add(fj_agg_s* agg, const dom::document* doc, uint64_t document, size_t root) {
+    size_t vidx;
+    if (path_walk(doc, document, root, &agg->value_path, &vidx) != FJ_SUCCESS) {
+        agg->skipped++;
+        return;
+    }
+
+    agg_group* group;
+    if (agg->grouped) {
+        size_t gidx;
+        if (path_walk(doc, document, root, &agg->group_path, &gidx) != FJ_SUCCESS) {
+            agg->skipped++;
+            return;
+        }
+        internal::tape_ref g(doc, gidx);
+        if (g.tape_ref_type() != internal::tape_type::STRING) {
+            agg->skipped++;
+            return;
+        }
+        group = agg_find_group(agg, g.get_c_str(), g.get_string_length());
+    } else {
+        group = agg_find_group(agg, "", 0);
+    }
+
+    internal::tape_ref t(doc, vidx);
+    double x;
+    group->count++;
+    switch (t.tape_ref_type()) {
+        case internal::tape_type::INT64:
+            x = static_cast<double>(t.next_tape_value<int64_t>());
+            break;
+        case internal::tape_type::UINT64:
+            x = static_cast<double>(t.next_tape_value<uint64_t>());
+            break;
+        case internal::tape_type::DOUBLE:
+            x = t.next_tape_value<double>();
+            break;
+        case internal::tape_type::STRING:
+            hll_add(group->hll, hash_bytes(t.get_c_str(), t.get_string_length(), 1));
+            return;
+        case internal::tape_type::TRUE_VALUE:
+        case internal::tape_type::FALSE_VALUE:
+        case internal::tape_type::NULL_VALUE:
+            hll_add(group->hll, fmix64(static_cast<uint64_t>(t.tape_ref_type())));
+            return;
+        default:
+            return;     /* Containers count but are not numeric or distinct */
+    }
+
+    group->numeric_count++;
+    group->sum += x;
+    if (x < group->min) group->min = x;
+    if (x > group->max) group->max = x;
+    /* Hash by value so 1 and 1.0 count once; fold -0.0 into 0.0 */
+    if (x == 0) x = 0;
+    uint64_t bits;
+    std::memcpy(&bits, &x, sizeof(bits));
+    hll_add(group->hll, fmix64(bits ^ 0x9e3779b97f4a7c15ULL));
+}
+
+/* ============================================================================
+ * Serialization Helpers
+ * ============================================================================ */
+
+/* Buffers output in 64 KiB blocks in front of a caller-supplied sink */
+class sink_buffer {
+public:
+    explicit sink_buffer(const fj_sink* sink) : sink_(*sink), len_(0), failed_(false) {}
+    
+    inline void put(char c) {
+        if (len_ == sizeof(buf_)) flush();
+        buf_[len_++] = c;
+    }
+    
+    inline void put(const char* data, size_t len) {
+        if (len > sizeof(buf_) - len_) {
+            flush();
+            if (len > sizeof(buf_)) {
+                if (!failed_ && !sink_.write(sink_.ctx, data, len)) failed_ = true;
+                return;
+            }
+        }
+        std::memcpy(buf_ + len_, data, len);
+        len_ += len;
+    }
+    
+    /* Flush buffered bytes; false once the sink has refused a write */
+    bool flush() {
+        if (len_ > 0 && !failed_ && !sink_.write(sink_.ctx, buf_, len_)) failed_ = true;
+        len_ = 0;
+        return !failed_;
+    }
+    
+    bool failed() const { return failed_; }
+    
+private:
+    fj_sink sink_;
+    char buf_[64 * 1024];
+    size_t len_;
+    bool failed_;
+};
+
+/* True for bytes that need escaping in a JSON string: < 0x20, '"' or '\\' */
+static inline uint64_t escape_mask(uint64_t w) {
+    const uint64_t ones = 0x0101010101010101ULL;
+    const uint64_t high = 0x8080808080808080ULL;
+    uint64_t quote = w ^ (ones * '"');
+    uint64_t slash = w ^ (ones * '\\');
+    uint64_t ctrl = (w - ones * 0x20) & ~w;
+    uint64_t q = (quote - ones) & ~quote;
+    uint64_t s = (slash - ones) & ~slash;
+    return (ctrl | q | s) & high;
+}
+
+/* Write a string with minimal escaping (RFC 8785 / ECMAScript JSON.stringify) */
+static void write_string(sink_buffer& out, const char* s, size_t len) {
+    static const char hex[] = "0123456789abcdef";
+    out.put('"');
+    size_t start = 0;
+    size_t i = 0;
+    while (i < len) {
+        /* Skip 8 clean bytes at a time */
+        if (i + 8 <= len) {
+            uint64_t w;
+            std::memcpy(&w, s + i, sizeof(w));
+            if (escape_mask(w) == 0) {
+                i += 8;
+                continue;
+            }
+        }
+        unsigned char c = static_cast<unsigned char>(s[i]);
+        if (c >= 0x20 && c != '"' && c != '\\') {
+            i++;
+            continue;
+        }
+        out.put(s + start, i - start);
+        switch (c) {
+            case '"':  out.put("\\\"", 2); break;
+            case '\\': out.put("\\\\", 2); break;
+            case '\b': out.put("\\b", 2); break;
+            case '\f': out.put("\\f", 2); break;
+            case '\n': out.put("\\n", 2); break;
+            case '\r': out.put("\\r", 2); break;
+            case '\t': out.put("\\t", 2); break;
+            default: {
+                char u[6] = {'\\', 'u', '0', '0', hex[c >> 4], hex[c & 0xF]};
+                out.put(u, sizeof(u));
+            }
+        }
+        start = ++i;
+    }
+    out.put(s + start, len - start);
+    out.put('"');
+}
+
+/*
+ * Format a double the way ECMAScript Number.prototype.toString does
+ * (RFC 8785 section 3.2.2.3): shortest round-trip digits, plain notation
+ * for exponents in [-6, 21), otherwise d.ddde+N. Returns the length.
+ */
+static size_t format_es_double(double x, char* out) {
+    if (x == 0) {
+        out[0] = '0';
+        return 1;
+    }
+    char tmp[64];
+    char* end;
+#if defined(__cpp_lib_to_chars)
+    end = std::to_chars(tmp, tmp + sizeof(tmp), x, std::chars_format::scientific).ptr;
+#else
+    end = internal::to_chars(tmp, tmp + sizeof(tmp), x);
+#endif
+    
+    /* Reduce whatever notation we got to digits and a decimal point position */
+    bool negative = false;
+    char digits[32];
+    int ndigits = 0;
+    int point = 0;          /* value = 0.digits * 10^point */
+    bool seen_point = false;
+    const char* p = tmp;
+    if (*p == '-') {
+        negative = true;
+        p++;
+    }
+    for (; p < end && *p != 'e' && *p != 'E'; p++) {
+        if (*p == '.') {
+            seen_point = true;
+            continue;
+        }
+        if (ndigits == 0 && *p == '0') {
+            if (seen_point) point--;
+            continue;
+        }
+        if (ndigits < static_cast<int>(sizeof(digits))) digits[ndigits++] = *p;
+        if (!seen_point) point++;
+    }
+    if (p < end) {
+        int e = 0;
+        bool e_negative = false;
+        for (p++; p < end; p++) {
+            if (*p == '-') e_negative = true;
+            else if (*p >= '0' && *p <= '9') e = e * 10 + (*p - '0');
+        }
+        point += e_negative ? -e : e;
+    }
+    while (ndigits > 1 && digits[ndigits - 1] == '0') ndigits--;
+    
+    size_t n = 0;
+    if (negative) out[n++] = '-';
+    if (ndigits <= point && point <= 21) {
+        std::memcpy(out + n, digits, ndigits);
+        n += ndigits;
+        for (int i = ndigits; i < point; i++) out[n++] = '0';
+    } else if (0 < point && point <= 21) {
+        std::memcpy(out + n, digits, point);
+        n += point;
+        out[n++] = '.';
+        std::memcpy(out + n, digits + point, ndigits - point);
+        n += ndigits - point;
+    } else if (-6 < point && point <= 0) {
+        out[n++] = '0';
+        out[n++] = '.';
+        for (int i = point; i < 0; i++) out[n++] = '0';
+        std::memcpy(out + n, digits, ndigits);
+        n += ndigits;
+    } else {
+        out[n++] = digits[0];
+        if (ndigits > 1) {
+            out[n++] = '.';
+            std::memcpy(out + n, digits + 1, ndigits - 1);
+            n += ndigits - 1;
+        }
+        int e = point - 1;
+        out[n++] = 'e';
+        out[n++] = e < 0 ? '-' : '+';
+        if (e < 0) e = -e;
+        char ebuf[8];
+        int elen = 0;
+        do {
+            ebuf[elen++] = static_cast<char>('0' + e % 10);
+            e /= 10;
+        } while (e);
+        while (elen) out[n++] = ebuf[--elen];
+    }
+    return n;
+}
+
+/* Write a tape number in canonical form: every JSON number is an IEEE double */
+static void write_canonical_number(sink_buffer& out, const internal::tape_ref& t) {
+    char buf[64];
+    size_t n;
+    const int64_t exact = int64_t(1) << 53;
+    switch (t.tape_ref_type()) {
+        case internal::tape_type::INT64: {
+            int64_t v = t.next_tape_value<int64_t>();
+            if (v >= -exact && v <= exact) {
+                n = static_cast<size_t>(std::snprintf(buf, sizeof(buf), "%lld",
+                                                      static_cast<long long>(v)));
+            } else {
+                n = format_es_double(static_cast<double>(v), buf);
+            }
+            break;
+        }
+        case internal::tape_type::UINT64: {
+            uint64_t v = t.next_tape_value<uint64_t>();
+            if (v <= static_cast<uint64_t>(exact)) {
+                n = static_cast<size_t>(std::snprintf(buf, sizeof(buf), "%llu",
+                                                      static_cast<unsigned long long>(v)));
+            } else {
+                n = format_es_double(static_cast<double>(v), buf);
+            }
+            break;
+        }
+        default:
+            n = format_es_double(t.next_tape_value<double>(), buf);
+    }
+    out.put(buf, n);
+}
+
+/* Decode the UTF-8 sequence at s (already validated by the parser) */
+static inline uint32_t utf8_code_point(const unsigned char* s) {
+    if (s[0] < 0x80) return s[0];
+    if (s[0] < 0xE0) return ((s[0] & 0x1Fu) << 6) | (s[1] & 0x3Fu);
+    if (s[0] < 0xF0) return ((s[0] & 0x0Fu) << 12) | ((s[1] & 0x3Fu) << 6) | (s[2] & 0x3Fu);
+    return ((s[0] & 0x07u) << 18) | ((s[1] & 0x3Fu) << 12) | ((s[2] & 0x3Fu) << 6) | (s[3] & 0x3Fu);
+}
+
+/*
+ * Order two UTF-8 keys by their UTF-16 code units, as RFC 8785 requires.
+ * Byte order equals code point order, which differs from UTF-16 order only
+ * when a supplementary character (surrogate pair) meets U+E000..U+FFFF.
+ */
+static bool utf16_key_less(const internal::tape_ref& a, const internal::tape_ref& b) {
+    const unsigned char* x = reinterpret_cast<const unsigned char*>(a.get_c_str());
+    const unsigned char* y = reinterpret_cast<const unsigned char*>(b.get_c_str());
+    size_t xl = a.get_string_length();
+    size_t yl = b.get_string_length();
+    size_t n = xl < yl ? xl : yl;
+    size_t i = 0;
+    while (i < n && x[i] == y[i]) i++;
+    if (i == n) return xl < yl;
+    if (x[i] < 0xEE && y[i] < 0xEE) return x[i] < y[i];
+    
+    /* Both sequences start at the same offset: back up to the lead byte */
+    while (i > 0 && (x[i] & 0xC0) == 0x80) i--;
+    uint32_t cx = utf8_code_point(x + i);
+    uint32_t cy = utf8_code_point(y + i);
+    bool px = cx >= 0x10000;
+    bool py = cy >= 0x10000;
+    if (px == py) return cx < cy;
+    /* A surrogate (0xD800..0xDBFF lead) sorts before U+E000.. and after U+D7FF */
+    return px ? cy >= 0xE000 : cx < 0xD800;
+}
+
+/* Write a tape number as parsed: integers exactly, doubles shortest round-trip */
+static void write_number(sink_buffer& out, const internal::tape_ref& t) {
+    char buf[64];
+    int n;
+    switch (t.tape_ref_type()) {
+        case internal::tape_type::INT64:
+            n = std::snprintf(buf, sizeof(buf), "%lld", static_cast<long long>(t.next_tape_value<int64_t>()));
+            break;
+        case internal::tape_type::UINT64:
+            n = std::snprintf(buf, sizeof(buf), "%llu",
+                              static_cast<unsigned long long>(t.next_tape_value<uint64_t>()));
+            break;
+        default:
+            n = static_cast<int>(format_es_double(t.next_tape_value<double>(), buf));
+    }
+    out.put(buf, static_cast<size_t>(n));
+}
+
+/* Write the subtree at tape index idx as minified JSON, in document order */
+static void write_tape(sink_buffer& out, const dom::document* doc, size_t idx) {
+    internal::tape_ref t(doc, idx);
+    switch (t.tape_ref_type()) {
+        case internal::tape_type::START_OBJECT: {
+            const size_t end = t.matching_brace_index() - 1;
+            out.put('{');
+            for (size_t k = idx + 1; k < end; k = internal::tape_ref(doc, k + 1).after_element()) {
+                if (k > idx + 1) out.put(',');
+                internal::tape_ref key(doc, k);
+                write_string(out, key.get_c_str(), key.get_string_length());
+                out.put(':');
+                write_tape(out, doc, k + 1);
+            }
+            out.put('}');
+            break;
+        }
+        case internal::tape_type::START_ARRAY: {
+            const size_t end = t.matching_brace_index() - 1;
+            out.put('[');
+            for (size_t k = idx + 1; k < end; k = internal::tape_ref(doc, k).after_element()) {
+                if (k > idx + 1) out.put(',');
+                write_tape(out, doc, k);
+            }
+            out.put(']');
+            break;
+        }
+        case internal::tape_type::STRING:
+            write_string(out, t.get_c_str(), t.get_string_length());
+            break;
+        case internal::tape_type::INT64:
+        case internal::tape_type::UINT64:
+        case internal::tape_type::DOUBLE:
+            write_number(out, t);
+            break;
+        case internal::tape_type::TRUE_VALUE:
+            out.put("true", 4);
+            break;
+        case internal::tape_type::FALSE_VALUE:
+            out.put("false", 5);
+            break;
+        default:
+            out.put("null", 4);
+    }
+}
+
+/*
+ * Write the subtree at tape index idx in canonical form. Object keys are
+ * sorted through a shared scratch stack of key tape indexes, one range per
+ * open object.
+ */
+static void write_canonical(sink_buffer& out, const dom::document* doc, size_t idx,
+                            std::vector<size_t>& scratch) {
+    internal::tape_ref t(doc, idx);
+    switch (t.tape_ref_type()) {
+        case internal::tape_type::START_OBJECT: {
+            const size_t end = t.matching_brace_index() - 1;
+            const size_t base = scratch.size();
+            for (size_t k = idx + 1; k < end; k = internal::tape_ref(doc, k + 1).after_element()) {
+                scratch.push_back(k);
+            }
+            std::stable_sort(scratch.begin() + base, scratch.end(), [doc](size_t l, size_t r) {
+                return utf16_key_less(internal::tape_ref(doc, l), internal::tape_ref(doc, r));
+            });
+            out.put('{');
+            for (size_t i = base; i < scratch.size(); i++) {
+                if (i > base) out.put(',');
+                internal::tape_ref key(doc, scratch[i]);
+                write_string(out, key.get_c_str(), key.get_string_length());
+                out.put(':');
+                write_canonical(out, doc, scratch[i] + 1, scratch);
+            }
+            out.put('}');
+            scratch.resize(base);
+            break;
+        }
+        case internal::tape_type::START_ARRAY: {
+            const size_t end = t.matching_brace_index() - 1;
+            out.put('[');
+            for (size_t k = idx + 1; k < end; k = internal::tape_ref(doc, k).after_element()) {
+                if (k > idx + 1) out.put(',');
+                write_canonical(out, doc, k, scratch);
+            }
+            out.put(']');
+            break;
+        }
+        case internal::tape_type::STRING:
+            write_string(out, t.get_c_str(), t.get_string_length());
+            break;
+        case internal::tape_type::INT64:
+        case internal::tape_type::UINT64:
+        case internal::tape_type::DOUBLE:
+            write_canonical_number(out, t);
+            break;
+        case internal::tape_type::TRUE_VALUE:
+            out.put("true", 4);
+            break;
+        case internal::tape_type::FALSE_VALUE:
+            out.put("false", 5);
+            break;
+        default:
+            out.put("null", 4);
+    }
+}
+
+/* ============================================================================
+ * Diff Helpers
+ * ============================================================================ */
+
+static inline bool tape_is_number(internal::tape_type t) {
+    return t == internal::tape_type::INT64 || t == internal::tape_type::UINT64 ||
+           t == internal::tape_type::DOUBLE;
+}
+
+/* An integer equals a double only if the double holds exactly that integer */
+static inline bool int_equals_double(int64_t i, double d) {
+    return d >= -9223372036854775808.0 && d < 9223372036854775808.0 &&
+           static_cast<int64_t>(d) == i && static_cast<double>(i) == d;
+}
+
+static inline bool uint_equals_double(uint64_t u, double d) {
+    return d >= 0 && d < 18446744073709551616.0 &&
+           static_cast<uint64_t>(d) == u && static_cast<double>(u) == d;
+}
+
+/*
+ * Compare two numbers stored with different tape types exactly: int64
+ * against uint64 by sign and value, an integer against a double only
+ * when the double is that integer (no rounding through double).
+ */
+static bool tape_mixed_numbers_equal(const internal::tape_ref& x, const internal::tape_ref& y) {
+    auto tx = x.tape_ref_type();
+    auto ty = y.tape_ref_type();
+    if (tx == internal::tape_type::DOUBLE) return tape_mixed_numbers_equal(y, x);
+    if (ty == internal::tape_type::DOUBLE) {
+        const double d = y.next_tape_value<double>();
+        return tx == internal::tape_type::INT64
+            ? int_equals_double(x.next_tape_value<int64_t>(), d)
+            : uint_equals_double(x.next_tape_value<uint64_t>(), d);
+    }
+    /* One INT64, one UINT64 */
+    const int64_t i = tx == internal::tape_type::INT64 ? x.next_tape_value<int64_t>() : y.next_tape_value<int64_t>();
+    const uint64_t u = tx == internal::tape_type::UINT64 ? x.next_tape_value<uint64_t>() : y.next_tape_value<uint64_t>();
+    return i >= 0 && static_cast<uint64_t>(i) == u;
+}
+
+/*
+ * Compare two subtrees word by word along their tapes, stopping at the
+ * first difference. Objects must list keys in the same order to compare
+ * equal here; callers fall back to a per-key walk when they do not.
+ */
+static bool tape_subtree_equal(const dom::document* da, size_t ai,
+                               const dom::document* db, size_t bi) {
+    const size_t aend = internal::tape_ref(da, ai).after_element();
+    size_t i = ai;
+    size_t j = bi;
+    while (i < aend) {
+        internal::tape_ref x(da, i);
+        internal::tape_ref y(db, j);
+        auto tx = x.tape_ref_type();
+        auto ty = y.tape_ref_type();
+        if (tx != ty) {
+            if (!tape_is_number(tx) || !tape_is_number(ty) || !tape_mixed_numbers_equal(x, y)) {
+                return false;
+            }
+            i += 2;
+            j += 2;
+            continue;
+        }
+        switch (tx) {
+            case internal::tape_type::START_OBJECT:
+            case internal::tape_type::START_ARRAY:
+                /* Same tape length implies the same number of words below */
+                if (x.matching_brace_index() - i != y.matching_brace_index() - j) return false;
+                i++;
+                j++;
+                break;
+            case internal::tape_type::STRING:
+                if (x.get_string_length() != y.get_string_length() ||
+                    std::memcmp(x.get_c_str(), y.get_c_str(), x.get_string_length()) != 0) {
+                    return false;
+                }
+                i++;
+                j++;
+                break;
+            case internal::tape_type::INT64:
+            case internal::tape_type::UINT64:
+                if (x.next_tape_value<uint64_t>() != y.next_tape_value<uint64_t>()) return false;
+                i += 2;
+                j += 2;
+                break;
+            case internal::tape_type::DOUBLE:
+                if (x.next_tape_value<double>() != y.next_tape_value<double>()) return false;
+                i += 2;
+                j += 2;
+                break;
+            default:
+                i++;
+                j++;
+        }
+    }
+    return true;
+}
+
+/* Append one JSON Pointer reference token (RFC 6901 escaping) */
+static void pointer_push(std::string& path, const char* token, size_t len) {
+    path += '/';
+    for (size_t i = 0; i < len; i++) {
+        if (token[i] == '~') path += "~0";
+        else if (token[i] == '/') path += "~1";
+        else path += token[i];
+    }
+}
+
+static void pointer_push_index(std::string& path, size_t idx) {
+    char buf[24];
+    int n = std::snprintf(buf, sizeof(buf), "/%zu", idx);
+    path.append(buf, static_cast<size_t>(n));
+}
+
+/*
+ * Walks two tapes together and reports changes as JSON Pointer paths with
+ * the tape indexes of the old and new values (0 when absent). Changes come
+ * out in an order that is valid to apply sequentially as an RFC 6902 patch.
+ */
+class tape_differ {
+public:
+    typedef bool (*emit_fn)(void* ctx, fj_diff_op op, const std::string& path,
+                            const dom::document* da, size_t ai,
+                            const dom::document* db, size_t bi);
+    
+    tape_differ(const dom::document* da, const dom::document* db, emit_fn emit, void* ctx)
+        : da_(da), db_(db), emit_(emit), ctx_(ctx), stopped_(false) {}
+    
+    void diff(size_t ai, size_t bi) {
+        if (stopped_ || tape_subtree_equal(da_, ai, db_, bi)) return;
+        auto ta = internal::tape_ref(da_, ai).tape_ref_type();
+        auto tb = internal::tape_ref(db_, bi).tape_ref_type();
+        if (ta == internal::tape_type::START_OBJECT && tb == internal::tape_type::START_OBJECT) {
+            diff_object(ai, bi);
+        } else if (ta == internal::tape_type::START_ARRAY && tb == internal::tape_type::START_ARRAY) {
+            diff_array(ai, bi);
+        } else {
+            emit(FJ_DIFF_REPLACE, ai, bi);
+        }
+    }
+    
+    bool stopped() const { return stopped_; }
+    
+private:
+    void emit(fj_diff_op op, size_t ai, size_t bi) {
+        if (!stopped_ && !emit_(ctx_, op, path_, da_, ai, db_, bi)) stopped_ = true;
+    }
+    
+    void diff_object(size_t ai, size_t bi) {
+        /* Index b's fields once; matched[] marks the ones a also has */
+        const size_t base = bkeys_.size();
+        const size_t bend = internal::tape_ref(db_, bi).matching_brace_index() - 1;
+        for (size_t k = bi + 1; k < bend; k = internal::tape_ref(db_, k + 1).after_element()) {
+            bkeys_.push_back(k);
+            matched_.push_back(0);
+        }
+        const size_t count = bkeys_.size() - base;
+        std::unique_ptr<std::unordered_map<std::string_view, size_t>> index;
+        
+        const size_t aend = internal::tape_ref(da_, ai).matching_brace_index() - 1;
+        size_t ordinal = 0;
+        for (size_t k = ai + 1; k < aend && !stopped_;
+             k = internal::tape_ref(da_, k + 1).after_element(), ordinal++) {
+            internal::tape_ref key(da_, k);
+            std::string_view name(key.get_c_str(), key.get_string_length());
+            
+            /* Same position first, then a scan or a hash index for large objects */
+            size_t found = count;
+            if (ordinal < count && key_at(base + ordinal) == name) {
+                found = ordinal;
+            } else if (count <= 16) {
+                for (size_t f = 0; f < count; f++) {
+                    if (key_at(base + f) == name) {
+                        found = f;
+                        break;
+                    }
+                }
+            } else {
+                if (!index) {
+                    index.reset(new std::unordered_map<std::string_view, size_t>());
+                    index->reserve(count);
+                    for (size_t f = 0; f < count; f++) index->emplace(key_at(base + f), f);
+                }
+                auto it = index->find(name);
+                if (it != index->end()) found = it->second;
+            }
+            
+            const size_t mark = path_.size();
+            pointer_push(path_, name.data(), name.size());
+            if (found < count) {
+                matched_[base + found] = 1;
+                diff(k + 1, bkeys_[base + found] + 1);
+            } else {
+                emit(FJ_DIFF_REMOVE, k + 1, 0);
+            }
+            path_.resize(mark);
+        }
+        
+        for (size_t f = 0; f < count && !stopped_; f++) {
+            if (matched_[base + f]) continue;
+            internal::tape_ref key(db_, bkeys_[base + f]);
+            const size_t mark = path_.size();
+            pointer_push(path_, key.get_c_str(), key.get_string_length());
+            emit(FJ_DIFF_ADD, 0, bkeys_[base + f] + 1);
+            path_.resize(mark);
+        }
+        bkeys_.resize(base);
+        matched_.resize(base);
+    }
+    
+    void diff_array(size_t ai, size_t bi) {
+        const size_t aend = internal::tape_ref(da_, ai).matching_brace_index() - 1;
+        const size_t bend = internal::tape_ref(db_, bi).matching_brace_index() - 1;
+        size_t i = ai + 1;
+        size_t j = bi + 1;
+        size_t n = 0;
+        const size_t mark = path_.size();
+        
+        /* Pairwise over the common prefix */
+        for (; i < aend && j < bend && !stopped_; n++) {
+            pointer_push_index(path_, n);
+            diff(i, j);
+            path_.resize(mark);
+            i = internal::tape_ref(da_, i).after_element();
+            j = internal::tape_ref(db_, j).after_element();
+        }
+        
+        /* Surplus in a: remove from the back so earlier indexes stay valid */
+        if (i < aend) {
+            std::vector<size_t> tail;
+            for (; i < aend; i = internal::tape_ref(da_, i).after_element()) tail.push_back(i);
+            for (size_t t = tail.size(); t-- > 0 && !stopped_;) {
+                pointer_push_index(path_, n + t);
+                emit(FJ_DIFF_REMOVE, tail[t], 0);
+                path_.resize(mark);
+            }
+        }
+        
+        /* Surplus in b: append in order */
+        for (; j < bend && !stopped_; j = internal::tape_ref(db_, j).after_element(), n++) {
+            pointer_push_index(path_, n);
+            emit(FJ_DIFF_ADD, 0, j);
+            path_.resize(mark);
+        }
+    }
+    
+    std::string_view key_at(size_t slot) const {
+        internal::tape_ref key(db_, bkeys_[slot]);
+        return std::string_view(key.get_c_str(), key.get_string_length());
+    }
+    
+    const dom::document* da_;
+    const dom::document* db_;
+    emit_fn emit_;
+    void* ctx_;
+    bool stopped_;
+    std::string path_;
+    std::vector<size_t> bkeys_;      /* Scratch stack: b's field key indexes per open object */
+    std::vector<uint8_t> matched_;
+};
+
+/* tape_differ sink writing an RFC 6902 patch array */
+struct patch_writer {
+    sink_buffer* out;
+    bool first;
+};
+
+static bool emit_patch_op(void* ctx, fj_diff_op op, const std::string& path,
+                          const dom::document*, size_t,
+                          const dom::document* db, size_t bi) {
+    patch_writer* w = static_cast<patch_writer*>(ctx);
+    sink_buffer& out = *w->out;
+    if (!w->first) out.put(',');
+    w->first = false;
+    const char* head = op == FJ_DIFF_ADD ? "{\"op\":\"add\",\"path\":"
+                     : op == FJ_DIFF_REMOVE ? "{\"op\":\"remove\",\"path\":"
+                     : "{\"op\":\"replace\",\"path\":";
+    out.put(head, std::strlen(head));
+    write_string(out, path.data(), path.size());
+    if (op != FJ_DIFF_REMOVE) {
+        out.put(",\"value\":", 9);
+        write_tape(out, db, bi);
+    }
+    out.put('}');
+    return !out.failed();
+}
+
+/* ============================================================================
+ * Source Map Helpers
+ * ============================================================================ */
+
+/*
+ * Map every tape word of d to the offset of its token in the input. The
+ * parser's structural index lists each token once, plus the ',' and ':'
+ * separators the tape leaves out, so one pass pairs them up. The index is
+ * only valid until the parser runs again, which also invalidates d, so the
+ * map is built on first use, once even when several threads read d. An
+ * allocation failure leaves it unbuilt for the next call to retry.
+ * Returns false when no input is recorded.
+ */
+static void source_map_fill(fj_document_s* d) {
+    if (!d->source || !d->parser || !d->parser->parser.implementation) return;
+
+    const dom::document* doc = tape_of(&d->root).doc;
+    const internal::dom_parser_implementation& impl = *d->parser->parser.implementation;
+    const uint32_t* si = impl.structural_indexes.get();
+    const size_t n = impl.n_structural_indexes;
+    const size_t tape_len = internal::tape_ref(doc, 0).tape_value();    /* Past the final root word */
+    const char* src = d->source;
+
+    std::vector<uint32_t> map(tape_len);
+    size_t s = 0;
+    for (size_t i = 1; i + 1 < tape_len; ) {
+        while (s < n && (src[si[s]] == ',' || src[si[s]] == ':')) s++;
+        if (s == n) return;
+        map[i] = si[s++];
+        i += tape_is_number(internal::tape_ref(doc, i).tape_ref_type()) ? 2 : 1;
+    }
+    if (s != n) return;
+    d->source_map.swap(map);
+}
+
+static bool source_map_build(fj_document_s* d) {
+    std::call_once(d->source_map_once, source_map_fill, d);
+    return !d->source_map.empty();
+}
+
+/* Input offset just past the value at tape index idx (source map built) */
+static size_t source_end(const fj_document_s* d, size_t idx) {
+    internal::tape_ref t(tape_of(&d->root).doc, idx);
+    const char* src = d->source;
+    size_t pos = d->source_map[idx];
+    switch (t.tape_ref_type()) {
+        case internal::tape_type::START_OBJECT:
+        case internal::tape_type::START_ARRAY:
+            return d->source_map[t.matching_brace_index() - 1] + 1;
+        case internal::tape_type::STRING:
+            for (pos++; src[pos] != '"'; pos++) {
+                if (src[pos] == '\\') pos++;
+            }
+            return pos + 1;
+        default:
+            while (pos < d->source_len &&
+                   (std::isalnum(static_cast<unsigned char>(src[pos])) ||
+                    src[pos] == '-' || src[pos] == '+' || src[pos] == '.')) {
+                pos++;
+            }
+            return pos;
+    }
+}
+
+/*
+ * Input bytes of the string (or key) at tape index idx of doc when they
+ * need no unescaping, else null. Every escape is longer than what it
+ * decodes to, so a raw range of len bytes without a backslash is the
+ * whole string. Values of a MutableDocument may live on other tapes.
+ */
+static const char* source_string(fj_document_s* d, const dom::document* doc, size_t idx, size_t len) {
+    try {
+        if (doc != tape_of(&d->root).doc || !source_map_build(d)) return nullptr;
+    } catch (...) {
+        return nullptr;
+    }
+    const char* raw = d->source + d->source_map[idx] + 1;
+    return std::memchr(raw, '\\', len) ? nullptr : raw;
+}
+
+/*
+ * Input bytes between the quotes of the string at tape index idx of doc,
+ * escapes intact, or null when d has no source for it. len is the
+ * unescaped length on entry and the raw length on return.
+ */
+static const char* source_string_raw(fj_document_s* d, const dom::document* doc, size_t idx, size_t* len) {
+    if (const char* raw = source_string(d, doc, idx, *len)) return raw;
+    try {
+        if (doc != tape_of(&d->root).doc || !source_map_build(d)) return nullptr;
+    } catch (...) {
+        return nullptr;
+    }
+    size_t start = d->source_map[idx] + 1;
+    *len = source_end(d, idx) - 1 - start;
+    return d->source + start;
+}
+
+/* ============================================================================
+ * Edit Tree Helpers
+ * ============================================================================ */
+
+struct edit_node;
+
+/* One value of an edit tree: a tape value, or a rebuilt container */
+struct edit_ref {
+    std::string_view key;               /* Member name (object members only) */
+    const dom::document* doc;           /* Tape value, used while node is null */
+    size_t idx;
+    edit_node* node;
+};
+
+struct edit_node {
+    bool is_object;
+    std::vector<edit_ref> children;
+    const dom::document* frozen = nullptr;  /* Tape copy made by freeze(), until the next edit below */
+    size_t frozen_idx = 0;
+};
+
+static bool append_to_string(void* ctx, const char* data, size_t len) {
+    static_cast<std::string*>(ctx)->append(data, len);
+    return true;
+}
+
+static bool stop_on_change(void* ctx, fj_diff_op, const std::string&,
+                           const dom::document*, size_t, const dom::document*, size_t) {
+    *static_cast<bool*>(ctx) = true;
+    return false;
+}
+
+/*
+ * Overlay of edits on a parsed document. Only containers on edited paths
+ * are rebuilt, one level at a time, as lists of child references; every
+ * other value stays a reference into its tape. Serializing copies runs of
+ * untouched siblings of the base document straight from its input text.
+ */
+class edit_tree {
+public:
+    explicit edit_tree(fj_document_s* base)
+        : base_(base), base_doc_(tape_of(&base->root).doc), raw_(source_map_build(base)) {
+        root = { std::string_view(), base_doc_, tape_of(&base->root).json_index, nullptr };
+    }
+
+    edit_ref root;
+
+    /* Rebuild the container behind r as a child list; null for scalars */
+    edit_node* materialize(edit_ref& r) {
+        if (r.node) return r.node;
+        if (!r.doc) return nullptr;
+        internal::tape_ref t(r.doc, r.idx);
+        auto type = t.tape_ref_type();
+        if (type != internal::tape_type::START_OBJECT && type != internal::tape_type::START_ARRAY) {
+            return nullptr;
+        }
+        edit_node* node = new_node(type == internal::tape_type::START_OBJECT);
+        const size_t end = t.matching_brace_index() - 1;
+        if (node->is_object) {
+            for (size_t k = r.idx + 1; k < end; k = internal::tape_ref(r.doc, k + 1).after_element()) {
+                node->children.push_back({ internal::tape_ref(r.doc, k).get_string_view(), r.doc, k + 1, nullptr });
+            }
+        } else {
+            for (size_t k = r.idx + 1; k < end; k = internal::tape_ref(r.doc, k).after_element()) {
+                node->children.push_back({ std::string_view(), r.doc, k, nullptr });
+            }
+        }
+        r.node = node;
+        return node;
+    }
+
+    /* Rebuild r for an edit below it: its tape copy from freeze() goes stale */
+    edit_node* edit(edit_ref& r) {
+        edit_node* node = materialize(r);
+        if (node) node->frozen = nullptr;
+        return node;
+    }
+
+    edit_node* new_node(bool is_object) {
+        nodes_.emplace_back();
+        nodes_.back().is_object = is_object;
+        return &nodes_.back();
+    }
+
+    /* Deep copy: rebuilt containers must not be shared between two places */
+    edit_ref clone(const edit_ref& r) {
+        edit_ref c = r;
+        if (r.node) {
+            c.node = new_node(r.node->is_object);
+            for (const edit_ref& child : r.node->children) {
+                c.node->children.push_back(clone(child));
+            }
+        }
+        return c;
+    }
+
+    std::string_view intern(const std::string& s) {
+        names_.push_back(s);
+        return names_.back();
+    }
+
+    /* Parse a JSON text owned by the tree; *out references its root */
+    fj_error fragment(const char* json, size_t len, edit_ref* out) {
+        fragments_.emplace_back();
+        auto result = fragment_parser_.parse_into_document(fragments_.back(), json, len);
+        if (result.error()) return map_error(result.error());
+        dom::element e = result.value();
+        *out = { std::string_view(), &fragments_.back(), tape_of(&e).json_index, nullptr };
+        return FJ_SUCCESS;
+    }
+
+    /*
+     * Follow the first depth tokens of a JSON Pointer, rebuilding containers
+     * on the way so the target can be edited in place. *out stays valid until
+     * the parent's child list next changes. For edits only: reads use lookup().
+     */
+    fj_error resolve(const std::vector<std::string>& tokens, size_t depth, edit_ref** out) {
+        edit_ref* cur = &root;
+        for (size_t i = 0; i < depth; i++) {
+            edit_node* node = edit(*cur);
+            if (!node) return FJ_ERROR_INCORRECT_TYPE;
+            size_t pos;
+            fj_error err = find_child(node, tokens[i], &pos);
+            if (err != FJ_SUCCESS) return err;
+            cur = &node->children[pos];
+        }
+        *out = cur;
+        return FJ_SUCCESS;
+    }
+
+    /* RFC 6902 add: insert into an array, or set an object member */
+    fj_error add(const std::vector<std::string>& tokens, edit_ref value) {
+        if (tokens.empty()) {
+            value.key = std::string_view();
+            root = value;
+            return FJ_SUCCESS;
+        }
+        edit_ref* parent;
+        fj_error err = resolve(tokens, tokens.size() - 1, &parent);
+        if (err != FJ_SUCCESS) return err;
+        edit_node* node = edit(*parent);
+        if (!node) return FJ_ERROR_INCORRECT_TYPE;
+
+        const std::string& last = tokens.back();
+        if (node->is_object) {
+            for (edit_ref& child : node->children) {
+                if (child.key == last) {
+                    value.key = child.key;
+                    child = value;
+                    return FJ_SUCCESS;
+                }
+            }
+            value.key = intern(last);
+            node->children.push_back(value);
+            return FJ_SUCCESS;
+        }
+
+        value.key = std::string_view();
+        if (last == "-") {
+            node->children.push_back(value);
+            return FJ_SUCCESS;
+        }
+        if (!path_is_index(last)) return FJ_ERROR_INVALID_JSON_POINTER;
+        size_t pos = std::stoull(last);
+        if (pos > node->children.size()) return FJ_ERROR_INDEX_OUT_OF_BOUNDS;
+        node->children.insert(node->children.begin() + static_cast<std::ptrdiff_t>(pos), value);
+        return FJ_SUCCESS;
+    }
+
+    /* Set an object member, or overwrite an array element ("-" appends) */
+    fj_error set(const std::vector<std::string>& tokens, edit_ref value) {
+        if (!tokens.empty() && tokens.back() != "-") {
+            edit_ref* parent;
+            fj_error err = resolve(tokens, tokens.size() - 1, &parent);
+            if (err != FJ_SUCCESS) return err;
+            edit_node* node = materialize(*parent);
+            if (node && !node->is_object) return replace(tokens, value);
+        }
+        return add(tokens, value);
+    }
+
+    /* RFC 6902 remove; *removed (if given) receives the detached value */
+    fj_error remove(const std::vector<std::string>& tokens, edit_ref* removed) {
+        if (tokens.empty()) return FJ_ERROR_INVALID_JSON_POINTER;
+        edit_ref* parent;
+        fj_error err = resolve(tokens, tokens.size() - 1, &parent);
+        if (err != FJ_SUCCESS) return err;
+        edit_node* node = edit(*parent);
+        if (!node) return FJ_ERROR_INCORRECT_TYPE;
+        size_t pos;
+        err = find_child(node, tokens.back(), &pos);
+        if (err != FJ_SUCCESS) return err;
+        if (removed) *removed = node->children[pos];
+        node->children.erase(node->children.begin() + static_cast<std::ptrdiff_t>(pos));
+        return FJ_SUCCESS;
+    }
+
+    /* RFC 6902 replace: the target must exist */
+    fj_error replace(const std::vector<std::string>& tokens, edit_ref value) {
+        edit_ref* target;
+        fj_error err = resolve(tokens, tokens.size(), &target);
+        if (err != FJ_SUCCESS) return err;
+        value.key = target->key;
+        *target = value;
+        return FJ_SUCCESS;
+    }
+
+    /*
+     * Find the value at a JSON Pointer without rebuilding anything: below
+     * the last edited container the walk continues on the tape.
+     */
+    fj_error lookup(const std::vector<std::string>& tokens, edit_ref* out) {
+        edit_ref cur = root;
+        for (const std::string& token : tokens) {
+            if (cur.node) {
+                size_t pos;
+                fj_error err = find_child(cur.node, token, &pos);
+                if (err != FJ_SUCCESS) return err;
+                cur = cur.node->children[pos];
+                continue;
+            }
+            internal::tape_ref t(cur.doc, cur.idx);
+            size_t idx;
+            if (t.tape_ref_type() == internal::tape_type::START_OBJECT) {
+                idx = tape_find_field(cur.doc, cur.idx, token.data(), token.size());
+                if (idx == 0) return FJ_ERROR_NO_SUCH_FIELD;
+            } else if (t.tape_ref_type() == internal::tape_type::START_ARRAY) {
+                if (!path_is_index(token)) return FJ_ERROR_INVALID_JSON_POINTER;
+                idx = tape_find_index(t, std::stoull(token));
+                if (idx == 0) return FJ_ERROR_INDEX_OUT_OF_BOUNDS;
+            } else {
+                return FJ_ERROR_INCORRECT_TYPE;
+            }
+            cur = { std::string_view(), cur.doc, idx, nullptr };
+        }
+        *out = cur;
+        return FJ_SUCCESS;
+    }
+
+    /*
+     * Tape view of r: a rebuilt container is serialized and parsed again
+     * once, then reused until an edit below it.
+     */
+    fj_error freeze(const edit_ref& r, edit_ref* out) {
+        if (!r.node) {
+            *out = r;
+            return FJ_SUCCESS;
+        }
+        if (!r.node->frozen) {
+            std::string text;
+            fj_sink sink = { append_to_string, &text };
+            sink_buffer buf(&sink);
+            write(buf, r);
+            buf.flush();
+            edit_ref t = {};
+            fj_error err = fragment(text.data(), text.size(), &t);
+            if (err != FJ_SUCCESS) return err;
+            r.node->frozen = t.doc;
+            r.node->frozen_idx = t.idx;
+        }
+        *out = { r.key, r.node->frozen, r.node->frozen_idx, nullptr };
+        return FJ_SUCCESS;
+    }
+
+    /* True if r is a value on the base document's own tape */
+    bool in_base(const edit_ref& r) const {
+        return !r.node && r.doc == base_doc_;
+    }
+
+    /* RFC 6902 test equality: numbers by value, objects in any key order */
+    bool equals(const edit_ref& a, const dom::document* db, size_t bi) {
+        edit_ref t;
+        if (freeze(a, &t) != FJ_SUCCESS) return false;
+        bool changed = false;
+        tape_differ differ(t.doc, db, stop_on_change, &changed);
+        differ.diff(t.idx, bi);
+        return !changed;
+    }
+
+    /* RFC 7396 merge of the patch value at tape index pi into target */
+    void merge(edit_ref& target, const dom::document* pd, size_t pi) {
+        internal::tape_ref p(pd, pi);
+        if (p.tape_ref_type() != internal::tape_type::START_OBJECT) {
+            target = { target.key, pd, pi, nullptr };
+            return;
+        }
+        edit_node* node = edit(target);
+        if (!node || !node->is_object) {
+            node = new_node(true);
+            target.node = node;
+        }
+        const size_t end = p.matching_brace_index() - 1;
+        for (size_t k = pi + 1; k < end; k = internal::tape_ref(pd, k + 1).after_element()) {
+            std::string_view key = internal::tape_ref(pd, k).get_string_view();
+            bool is_null = internal::tape_ref(pd, k + 1).is_null_on_tape();
+            size_t pos = 0;
+            while (pos < node->children.size() && node->children[pos].key != key) pos++;
+            if (pos < node->children.size()) {
+                if (is_null) {
+                    node->children.erase(node->children.begin() + static_cast<std::ptrdiff_t>(pos));
+                } else {
+                    merge(node->children[pos], pd, k + 1);
+                }
+            } else if (!is_null) {
+                edit_ref child = { key, nullptr, 0, nullptr };
+                merge(child, pd, k + 1);
+                node->children.push_back(child);
+            }
+        }
+    }
+
+    /* Serialize r: raw input spans where untouched, minified elsewhere */
+    void write(sink_buffer& out, const edit_ref& r) {
+        if (!r.node) {
+            if (is_raw(r)) {
+                size_t from = base_->source_map[r.idx];
+                out.put(base_->source + from, source_end(base_, r.idx) - from);
+            } else {
+                write_tape(out, r.doc, r.idx);
+            }
+            return;
+        }
+
+        const bool obj = r.node->is_object;
+        const std::vector<edit_ref>& children = r.node->children;
+        out.put(obj ? '{' : '[');
+        size_t i = 0;
+        while (i < children.size()) {
+            if (i > 0) out.put(',');
+            const edit_ref& c = children[i];
+            if (is_raw_member(c, obj)) {
+                /* Tape neighbours sit side by side in the input too */
+                size_t j = i;
+                while (j + 1 < children.size() && is_raw_member(children[j + 1], obj) &&
+                       internal::tape_ref(base_doc_, children[j].idx).after_element() ==
+                           children[j + 1].idx - (obj ? 1 : 0)) {
+                    j++;
+                }
+                size_t from = base_->source_map[obj ? c.idx - 1 : c.idx];
+                out.put(base_->source + from, source_end(base_, children[j].idx) - from);
+                i = j + 1;
+                continue;
+            }
+            if (obj) {
+                write_string(out, c.key.data(), c.key.size());
+                out.put(':');
+            }
+            write(out, c);
+            i++;
+        }
+        out.put(obj ? '}' : ']');
+    }
+
+private:
+    fj_error find_child(edit_node* node, const std::string& token, size_t* pos) {
+        if (node->is_object) {
+            for (size_t i = 0; i < node->children.size(); i++) {
+                if (node->children[i].key == token) {
+                    *pos = i;
+                    return FJ_SUCCESS;
+                }
+            }
+            return FJ_ERROR_NO_SUCH_FIELD;
+        }
+        if (!path_is_index(token)) return FJ_ERROR_INVALID_JSON_POINTER;
+        *pos = std::stoull(token);
+        return *pos < node->children.size() ? FJ_SUCCESS : FJ_ERROR_INDEX_OUT_OF_BOUNDS;
+    }
+
+    bool is_raw(const edit_ref& r) const {
+        return raw_ && in_base(r);
+    }
+
+    /* Untouched base member whose key text in the input is still its key */
+    bool is_raw_member(const edit_ref& r, bool obj) const {
+        if (!is_raw(r)) return false;
+        if (!obj) return true;
+        internal::tape_ref k(base_doc_, r.idx - 1);
+        return k.tape_ref_type() == internal::tape_type::STRING && r.key.data() == k.get_c_str();
+    }
+
+    fj_document_s* base_;
+    const dom::document* base_doc_;
+    bool raw_;
+    std::deque<edit_node> nodes_;
+    std::deque<std::string> names_;
+    std::deque<dom::document> fragments_;
+    dom::parser fragment_parser_;
+};
+
+/* A document plus the edits recorded against it */
+struct fj_mutable_s {
+    fj_document_s* base;
+    edit_tree tree;
+    
+    explicit fj_mutable_s(fj_document_s* doc) : base(doc), tree(doc) {}
+};
+
+/* ============================================================================
+ * Patch Helpers
+ * ============================================================================ */
+
+/* Split the JSON Pointer held by string member name of op into tokens */
+static fj_error patch_pointer(const dom::document* pd, size_t op, const char* name,
+                              std::vector<std::string>& tokens) {
+    size_t idx = tape_find_field(pd, op, name, std::strlen(name));
+    if (idx == 0) return FJ_ERROR_INVALID_PATCH;
+    internal::tape_ref t(pd, idx);
+    if (t.tape_ref_type() != internal::tape_type::STRING) return FJ_ERROR_INVALID_PATCH;
+    return pointer_split(t.get_string_view().data(), t.get_string_length(), tokens);
+}
+
+/* Apply one RFC 6902 operation object at tape index op */
+static fj_error patch_apply_op(edit_tree& tree, const dom::document* pd, size_t op) {
+    size_t op_idx = tape_find_field(pd, op, "op", 2);
+    if (op_idx == 0 || internal::tape_ref(pd, op_idx).tape_ref_type() != internal::tape_type::STRING) {
+        return FJ_ERROR_INVALID_PATCH;
+    }
+    std::string_view name = internal::tape_ref(pd, op_idx).get_string_view();
+
+    std::vector<std::string> path;
+    fj_error err = patch_pointer(pd, op, "path", path);
+    if (err != FJ_SUCCESS) return err;
+
+    if (name == "remove") return tree.remove(path, nullptr);
+
+    if (name == "add" || name == "replace" || name == "test") {
+        size_t value = tape_find_field(pd, op, "value", 5);
+        if (value == 0) return FJ_ERROR_INVALID_PATCH;
+        edit_ref v = { std::string_view(), pd, value, nullptr };
+        if (name == "add") return tree.add(path, v);
+        if (name == "replace") return tree.replace(path, v);
+        edit_ref target;
+        err = tree.lookup(path, &target);
+        if (err != FJ_SUCCESS) return err;
+        return tree.equals(target, pd, value) ? FJ_SUCCESS : FJ_ERROR_PATCH_TEST_FAILED;
+    }
+
+    if (name == "move" || name == "copy") {
+        std::vector<std::string> from;
+        err = patch_pointer(pd, op, "from", from);
+        if (err != FJ_SUCCESS) return err;
+        edit_ref v;
+        if (name == "copy") {
+            edit_ref source;
+            err = tree.lookup(from, &source);
+            if (err != FJ_SUCCESS) return err;
+            v = tree.clone(source);
+        } else {
+            /* A value cannot move into one of its own children */
+            if (from.size() < path.size() && std::equal(from.begin(), from.end(), path.begin())) {
+                return FJ_ERROR_INVALID_PATCH;
+            }
+            if (from == path) {
+                edit_ref source;
+                return tree.lookup(from, &source);
+            }
+            err = tree.remove(from, &v);
+            if (err != FJ_SUCCESS) return err;
+        }
+        return tree.add(path, v);
+    }
+
+    return FJ_ERROR_INVALID_PATCH;
+}
+
+/* Shared front half of fj_apply_patch / fj_apply_merge_patch */
+static fj_error patch_run(fj_document doc, const char* patch, size_t patch_len,
+                          const fj_sink* sink, bool merge) {
+    if (!doc || !doc->parser || !patch || !sink || !sink->write) return FJ_ERROR_UNINITIALIZED;
+
+    try {
+        edit_tree tree(doc);
+        edit_ref p = {};
+        fj_error err = tree.fragment(patch, patch_len, &p);
+        if (err != FJ_SUCCESS) return err;
+
+        if (merge) {
+            tree.merge(tree.root, p.doc, p.idx);
+        } else {
+            internal::tape_ref ops(p.doc, p.idx);
+            if (ops.tape_ref_type() != internal::tape_type::START_ARRAY) return FJ_ERROR_INVALID_PATCH;
+            const size_t end = ops.matching_brace_index() - 1;
+            for (size_t k = p.idx + 1; k < end; k = internal::tape_ref(p.doc, k).after_element()) {
+                err = patch_apply_op(tree, p.doc, k);
+                if (err != FJ_SUCCESS) return err;
+            }
+        }
+
+        sink_buffer out(sink);
+        tree.write(out, tree.root);
+        return out.flush() ? FJ_SUCCESS : FJ_ERROR_IO_ERROR;
+    } catch (...) {
+        return FJ_ERROR_MEMALLOC;
+    }
+}
+
+/* ============================================================================
+ * Number Text Helpers
+ * ============================================================================ */
+
+/* Eight ASCII digits in a little-endian word (SWAR, as in simdjson) */
+static inline bool is_made_of_eight_digits(uint64_t val) {
+    return ((val & 0xF0F0F0F0F0F0F0F0) |
+            (((val + 0x0606060606060606) & 0xF0F0F0F0F0F0F0F0) >> 4)) == 0x3333333333333333;
+}
+
+static inline uint32_t parse_eight_digits(uint64_t val) {
+    const uint64_t mask = 0x000000FF000000FF;
+    const uint64_t mul1 = 0x000F424000000064;   /* 100 + (1000000 << 32) */
+    const uint64_t mul2 = 0x0000271000000001;   /* 1 + (10000 << 32) */
+    val -= 0x3030303030303030;
+    val = (val * 10) + (val >> 8);
+    val = (((val & mask) * mul1) + (((val >> 16) & mask) * mul2)) >> 32;
+    return uint32_t(val);
+}
+
+/* Whether text is exactly one JSON number (RFC 8259 grammar, no spaces) */
+static bool is_json_number(std::string_view text) {
+    const char* p = text.data();
+    const char* end = p + text.size();
+    auto digit = [&](const char* q) { return q < end && unsigned(*q - '0') <= 9; };
+    
+    if (p < end && *p == '-') p++;
+    if (!digit(p)) return false;
+    if (*p == '0') {
+        p++;
+    } else {
+        while (digit(p)) p++;
+    }
+    if (p < end && *p == '.') {
+        p++;
+        if (!digit(p)) return false;
+        while (digit(p)) p++;
+    }
+    if (p < end && (*p == 'e' || *p == 'E')) {
+        p++;
+        if (p < end && (*p == '+' || *p == '-')) p++;
+        if (!digit(p)) return false;
+        while (digit(p)) p++;
+    }
+    return p == end;
+}
+
+/* Parse an unsigned JSON integer (no sign, no leading zeros) */
+static fj_error parse_decimal_digits(std::string_view text, uint64_t* out) {
+    size_t n = text.size();
+    if (n == 0 || (text[0] == '0' && n > 1)) return FJ_ERROR_NUMBER_ERROR;
+    
+    uint64_t v = 0;
+    size_t i = 0;
+    /* Eight digits at a time while they cannot overflow */
+    for (; i + 8 <= n && i + 8 <= 16; i += 8) {
+        uint64_t chunk;
+        std::memcpy(&chunk, text.data() + i, 8);
+        if (!is_made_of_eight_digits(chunk)) break;
+        v = v * 100000000 + parse_eight_digits(chunk);
+    }
+    for (; i < n; i++) {
+        unsigned d = unsigned(text[i] - '0');
+        if (d > 9) return FJ_ERROR_NUMBER_ERROR;
+        if (v > (UINT64_MAX - d) / 10) {
+            /* Keep validating so that malformed text is not reported as too large */
+            for (i++; i < n; i++) {
+                if (unsigned(text[i] - '0') > 9) return FJ_ERROR_NUMBER_ERROR;
+            }
+            return FJ_ERROR_NUMBER_OUT_OF_RANGE;
+        }
+        v = v * 10 + d;
+    }
+    *out = v;
+    return FJ_SUCCESS;
+}
+
+/* ============================================================================
+ * Timestamp Helpers
+ * ============================================================================ */
+
+struct civil_time {
+    unsigned year, month, day;
+    unsigned hour, minute, second;
+};
+
+/* "YYYY-MM-DD" + "T" + "HH:MM:SS" with digits '0' and separators verbatim */
+static const uint64_t TS_TEMPLATE_LO = 0x2D30302D30303030;   /* "0000-00-" */
+static const uint64_t TS_TEMPLATE_HI = 0x30303A3030543030;   /* "00T00:00" */
+static const uint64_t TS_SEPARATORS_LO = 0xFF0000FF00000000;
+static const uint64_t TS_SEPARATORS_HI = 0x0000FF0000FF0000;
+
+/* Nonzero unless every byte of d (text XOR template) is a digit value 0-9 */
+static inline uint64_t swar_non_digits(uint64_t d) {
+    return (d & 0xF0F0F0F0F0F0F0F0) | ((d + 0x0606060606060606) & 0xF0F0F0F0F0F0F0F0);
+}
+
+/*
+ * Fixed-layout fast path for "YYYY-MM-DDTHH:MM:SS": the first sixteen bytes
+ * are checked against the template in two words, and digit pairs are combined
+ * in-register (byte i becomes 10 * d[i] + d[i + 1]).
+ */
+static inline bool timestamp_prefix_fast(const char* s, civil_time* t) {
+    uint64_t lo, hi;
+    std::memcpy(&lo, s, 8);
+    std::memcpy(&hi, s + 8, 8);
+    lo ^= TS_TEMPLATE_LO;
+    hi ^= TS_TEMPLATE_HI;
+    if ((swar_non_digits(lo) | swar_non_digits(hi) |
+         (lo & TS_SEPARATORS_LO) | (hi & TS_SEPARATORS_HI)) != 0) {
+        return false;
+    }
+    unsigned s0 = unsigned(s[17] - '0'), s1 = unsigned(s[18] - '0');
+    if (s[16] != ':' || s0 > 9 || s1 > 9) return false;
+
+    lo = lo * 10 + (lo >> 8);
+    hi = hi * 10 + (hi >> 8);
+    t->year = unsigned(lo & 0xFF) * 100 + unsigned((lo >> 16) & 0xFF);
+    t->month = unsigned((lo >> 40) & 0xFF);
+    t->day = unsigned(hi & 0xFF);
+    t->hour = unsigned((hi >> 24) & 0xFF);
+    t->minute = unsigned((hi >> 48) & 0xFF);
+    t->second = s0 * 10 + s1;
+    return true;
+}
+
+/* Scalar path: also takes the 't' and ' ' date/time separators of RFC 3339 */
+static bool timestamp_prefix_scalar(const char* s, civil_time* t) {
+    static const char layout[] = "dddd-dd-dd?dd:dd:dd";
+    unsigned digits[14];
+    unsigned n = 0;
+    for (size_t i = 0; i < 19; i++) {
+        char c = layout[i];
+        if (c == 'd') {
+            unsigned d = unsigned(s[i] - '0');
+            if (d > 9) return false;
+            digits[n++] = d;
+        } else if (c == '?') {
+            if (s[i] != 'T' && s[i] != 't' && s[i] != ' ') return false;
+        } else if (s[i] != c) {
+            return false;
+        }
+    }
+    t->year = digits[0] * 1000 + digits[1] * 100 + digits[2] * 10 + digits[3];
+    t->month = digits[4] * 10 + digits[5];
+    t->day = digits[6] * 10 + digits[7];
+    t->hour = digits[8] * 10 + digits[9];
+    t->minute = digits[10] * 10 + digits[11];
+    t->second = digits[12] * 10 + digits[13];
+    return true;
+}
+
+static inline unsigned days_in_month(unsigned year, unsigned month) {
+    static const uint8_t days[12] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+    bool leap = (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+    return days[month - 1] + (month == 2 && leap);
+}
+
+/* Days since 1970-01-01 of a proleptic Gregorian date (Hinnant's algorithm) */
+static inline int64_t days_from_civil(int64_t y, unsigned m, unsigned d) {
+    y -= m <= 2;
+    const int64_t era = (y >= 0 ? y : y - 399) / 400;
+    const unsigned yoe = unsigned(y - era * 400);
+    const unsigned doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1;
+    const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + int64_t(doe) - 719468;
+}
+
+/*
+ * Parse an RFC 3339 date-time into nanoseconds since the Unix epoch.
+ * Fractions beyond nanoseconds are truncated; a leap second (:60) rolls
+ * into the next minute.
+ */
+static fj_error parse_timestamp(const char* s, size_t n, int64_t* out) {
+    civil_time t;
+    if (n < 20) return FJ_ERROR_INVALID_TIMESTAMP;
+    if (!timestamp_prefix_fast(s, &t) && !timestamp_prefix_scalar(s, &t)) {
+        return FJ_ERROR_INVALID_TIMESTAMP;
+    }
+    if (t.month < 1 || t.month > 12 || t.day < 1 || t.day > days_in_month(t.year, t.month) ||
+        t.hour > 23 || t.minute > 59 || t.second > 60) {
+        return FJ_ERROR_INVALID_TIMESTAMP;
+    }
+
+    size_t i = 19;
+    int64_t nanos = 0;
+    if (s[i] == '.') {
+        size_t start = ++i;
+        while (i < n && unsigned(s[i] - '0') <= 9) {
+            if (i - start < 9) nanos = nanos * 10 + (s[i] - '0');
+            i++;
+        }
+        if (i == start) return FJ_ERROR_INVALID_TIMESTAMP;
+        for (size_t k = i - start; k < 9; k++) nanos *= 10;
+    }
+
+    int64_t offset = 0;
+    if (i < n && (s[i] == 'Z' || s[i] == 'z')) {
+        i++;
+    } else if (i + 6 == n && (s[i] == '+' || s[i] == '-') && s[i + 3] == ':') {
+        unsigned h0 = unsigned(s[i + 1] - '0'), h1 = unsigned(s[i + 2] - '0');
+        unsigned m0 = unsigned(s[i + 4] - '0'), m1 = unsigned(s[i + 5] - '0');
+        if (h0 > 9 || h1 > 9 || m0 > 9 || m1 > 9) return FJ_ERROR_INVALID_TIMESTAMP;
+        unsigned hours = h0 * 10 + h1, minutes = m0 * 10 + m1;
+        if (hours > 23 || minutes > 59) return FJ_ERROR_INVALID_TIMESTAMP;
+        offset = int64_t(hours * 60 + minutes) * 60;
+        if (s[i] == '-') offset = -offset;
+        i += 6;
+    } else {
+        return FJ_ERROR_INVALID_TIMESTAMP;
+    }
+    if (i != n) return FJ_ERROR_INVALID_TIMESTAMP;
+
+    int64_t seconds = days_from_civil(t.year, t.month, t.day) * 86400 +
+                      int64_t(t.hour * 3600 + t.minute * 60 + t.second) - offset;
+    int64_t result;
+    if (__builtin_mul_overflow(seconds, int64_t(1000000000), &result) ||
+        __builtin_add_overflow(result, nanos, &result)) {
+        return FJ_ERROR_NUMBER_OUT_OF_RANGE;
+    }
+    *out = result;
+    return FJ_SUCCESS;
+}
+
+/* ============================================================================
+ * Binary Decoding Helpers
+ * ============================================================================ */
+
+/* Sextet of each base64 character, standard and URL-safe alphabets; -1 if invalid */
+static constexpr std::array<int8_t, 256> make_base64_table() {
+    std::array<int8_t, 256> t{};
+    for (auto& v : t) v = -1;
+    for (int i = 0; i < 26; i++) {
+        t['A' + i] = int8_t(i);
+        t['a' + i] = int8_t(26 + i);
+    }
+    for (int i = 0; i < 10; i++) t['0' + i] = int8_t(52 + i);
+    t['+'] = t['-'] = 62;
+    t['/'] = t['_'] = 63;
+    return t;
+}
+
+static constexpr std::array<int8_t, 256> make_hex_table() {
+    std::array<int8_t, 256> t{};
+    for (auto& v : t) v = -1;
+    for (int i = 0; i < 10; i++) t['0' + i] = int8_t(i);
+    for (int i = 0; i < 6; i++) t['a' + i] = t['A' + i] = int8_t(10 + i);
+    return t;
+}
+
+static constexpr std::array<int8_t, 256> BASE64_TABLE = make_base64_table();
+static constexpr std::array<int8_t, 256> HEX_TABLE = make_hex_table();
+
+#if defined(__AVX2__)
+/*
+ * Decode 32 standard-alphabet characters into 24 bytes (Mula & Lemire).
+ * Characters are classified by nibble lookups and shifted to sextets in
+ * place, then packed with two multiply-adds. Returns false, writing
+ * nothing, if any character is outside the standard alphabet.
+ */
+static inline bool base64_block_avx2(const char* src, uint8_t* dst, bool wide_store) {
+    const __m256i lut_lo = _mm256_setr_epi8(
+        0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A,
+        0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+    const __m256i lut_hi = _mm256_setr_epi8(
+        0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+        0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+    const __m256i lut_roll = _mm256_setr_epi8(
+        0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+    const __m256i mask_2f = _mm256_set1_epi8(0x2F);
+
+    __m256i in = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src));
+    __m256i hi_nibbles = _mm256_and_si256(_mm256_srli_epi32(in, 4), mask_2f);
+    __m256i lo = _mm256_shuffle_epi8(lut_lo, _mm256_and_si256(in, mask_2f));
+    __m256i hi = _mm256_shuffle_epi8(lut_hi, hi_nibbles);
+    if (!_mm256_testz_si256(lo, hi)) return false;
+
+    __m256i eq_2f = _mm256_cmpeq_epi8(in, mask_2f);
+    in = _mm256_add_epi8(in, _mm256_shuffle_epi8(lut_roll, _mm256_add_epi8(eq_2f, hi_nibbles)));
+
+    __m256i merged = _mm256_maddubs_epi16(in, _mm256_set1_epi32(0x01400140));
+    merged = _mm256_madd_epi16(merged, _mm256_set1_epi32(0x00011000));
+    merged = _mm256_shuffle_epi8(merged, _mm256_setr_epi8(
+        2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+        2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+    merged = _mm256_permutevar8x32_epi32(merged, _mm256_setr_epi32(0, 1, 2, 4, 5, 6, -1, -1));
+
+    if (wide_store) {
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst), merged);
+    } else {
+        alignas(32) uint8_t tmp[32];
+        _mm256_store_si256(reinterpret_cast<__m256i*>(tmp), merged);
+        std::memcpy(dst, tmp, 24);
+    }
+    return true;
+}
+
+/* Decode 32 hex digits into 16 bytes; false, writing nothing, on a non-digit */
+static inline bool hex_block_avx2(const char* src, uint8_t* dst) {
+    __m256i c = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src));
+    __m256i lower = _mm256_or_si256(c, _mm256_set1_epi8(0x20));
+    __m256i digit = _mm256_and_si256(_mm256_cmpgt_epi8(c, _mm256_set1_epi8('0' - 1)),
+                                     _mm256_cmpgt_epi8(_mm256_set1_epi8('9' + 1), c));
+    __m256i letter = _mm256_and_si256(_mm256_cmpgt_epi8(lower, _mm256_set1_epi8('a' - 1)),
+                                      _mm256_cmpgt_epi8(_mm256_set1_epi8('f' + 1), lower));
+    if (_mm256_movemask_epi8(_mm256_or_si256(digit, letter)) != -1) return false;
+
+    /* '0'-'9' -> 0-9, 'A'-'F'/'a'-'f' -> 1-6 + 9 */
+    __m256i v = _mm256_add_epi8(_mm256_and_si256(c, _mm256_set1_epi8(0x0F)),
+                                _mm256_andnot_si256(digit, _mm256_set1_epi8(9)));
+    __m256i pairs = _mm256_maddubs_epi16(v, _mm256_set1_epi16(0x0110));
+    __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(pairs, pairs), 0xD8);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), _mm256_castsi256_si128(packed));
+    return true;
+}
+#endif
+
+/*
+ * Decode base64 (padded or not) into out. *len receives the decoded size,
+ * also when out is too small, so a first call can size the buffer.
+ */
+static fj_error base64_decode(const char* s, size_t n, uint8_t* out, size_t cap, size_t* len) {
+    if (n % 4 == 0 && n > 0 && s[n - 1] == '=') {
+        n -= s[n - 2] == '=' ? 2 : 1;
+    }
+    if (n % 4 == 1) return FJ_ERROR_INVALID_ENCODING;
+    const size_t need = n / 4 * 3 + (n % 4 ? n % 4 - 1 : 0);
+    *len = need;
+    if (need > cap) return FJ_ERROR_CAPACITY;
+
+    size_t i = 0, o = 0;
+#if defined(__AVX2__)
+    /* URL-safe or invalid blocks drop to the table loop, which decides */
+    for (; i + 32 <= n; i += 32, o += 24) {
+        if (!base64_block_avx2(s + i, out + o, o + 32 <= cap)) break;
+    }
+#endif
+    const uint8_t* u = reinterpret_cast<const uint8_t*>(s);
+    for (; i + 4 <= n; i += 4, o += 3) {
+        int32_t a = BASE64_TABLE[u[i]], b = BASE64_TABLE[u[i + 1]];
+        int32_t c = BASE64_TABLE[u[i + 2]], d = BASE64_TABLE[u[i + 3]];
+        if ((a | b | c | d) < 0) return FJ_ERROR_INVALID_ENCODING;
+        uint32_t v = uint32_t(a) << 18 | uint32_t(b) << 12 | uint32_t(c) << 6 | uint32_t(d);
+        out[o] = uint8_t(v >> 16);
+        out[o + 1] = uint8_t(v >> 8);
+        out[o + 2] = uint8_t(v);
+    }
+    if (i < n) {
+        int32_t a = BASE64_TABLE[u[i]], b = BASE64_TABLE[u[i + 1]];
+        int32_t c = n - i == 3 ? BASE64_TABLE[u[i + 2]] : 0;
+        if ((a | b | c) < 0) return FJ_ERROR_INVALID_ENCODING;
+        uint32_t v = uint32_t(a) << 18 | uint32_t(b) << 12 | uint32_t(c) << 6;
+        out[o] = uint8_t(v >> 16);
+        if (n - i == 3) out[o + 1] = uint8_t(v >> 8);
+    }
+    return FJ_SUCCESS;
+}
+
+/* Decode hex digits (either case) into out; *len as for base64_decode */
+static fj_error hex_decode(const char* s, size_t n, uint8_t* out, size_t cap, size_t* len) {
+    if (n % 2) return FJ_ERROR_INVALID_ENCODING;
+    *len = n / 2;
+    if (n / 2 > cap) return FJ_ERROR_CAPACITY;
+
+    size_t i = 0, o = 0;
+#if defined(__AVX2__)
+    for (; i + 32 <= n; i += 32, o += 16) {
+        if (!hex_block_avx2(s + i, out + o)) break;
+    }
+#endif
+    const uint8_t* u = reinterpret_cast<const uint8_t*>(s);
+    for (; i < n; i += 2, o++) {
+        int32_t hi = HEX_TABLE[u[i]], lo = HEX_TABLE[u[i + 1]];
+        if ((hi | lo) < 0) return FJ_ERROR_INVALID_ENCODING;
+        out[o] = uint8_t(hi << 4 | lo);
+    }
+    return FJ_SUCCESS;
+}
+
+/* ============================================================================
+ * Line Index Helpers
+ * ============================================================================ */
+
+/* Records per absolute base offset in the compact index */
+static const size_t LINE_INDEX_BLOCK_SHIFT = 8;
+
+/* Index file header; the tables follow in host byte order */
+struct line_index_header {
+    char magic[8];
+    uint64_t source_size;
+    uint64_t count;
+};
+
+static const char LINE_INDEX_MAGIC[8] = {'F', 'J', 'L', 'I', 'D', 'X', '0', '1'};
+
+struct fj_line_index_s {
+    uint64_t source_size;
+    uint64_t count;
+    const uint64_t* bases;              /* Offset of every 256th record */
+    const uint32_t* rel;                /* Offset of each record from its base */
+    std::vector<uint64_t> owned_bases;  /* Storage when built, empty when opened */
+    std::vector<uint32_t> owned_rel;
+    
+    fj_line_index_s() : source_size(0), count(0), bases(nullptr), rel(nullptr) {}
+};
+
+/* Call f(pos) for every '\n' in buf[from, to), 16-32 bytes per step */
+template <typename F>
+static void scan_newlines(const char* buf, size_t from, size_t to, F&& f) {
+    size_t i = from;
+#if defined(__AVX2__)
+    const __m256i nl = _mm256_set1_epi8('\n');
+    for (; i + 32 <= to; i += 32) {
+        __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(buf + i));
+        uint32_t m = uint32_t(_mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, nl)));
+        for (; m; m &= m - 1) f(i + size_t(__builtin_ctz(m)));
+    }
+#elif defined(__SSE2__)
+    const __m128i nl = _mm_set1_epi8('\n');
+    for (; i + 16 <= to; i += 16) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(buf + i));
+        uint32_t m = uint32_t(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, nl)));
+        for (; m; m &= m - 1) f(i + size_t(__builtin_ctz(m)));
+    }
+#elif defined(__ARM_NEON)
+    const uint8x16_t nl = vdupq_n_u8('\n');
+    for (; i + 16 <= to; i += 16) {
+        uint8x16_t eq = vceqq_u8(vld1q_u8(reinterpret_cast<const uint8_t*>(buf + i)), nl);
+        /* Narrow to one nibble per byte */
+        uint64_t m = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(eq), 4)), 0);
+        while (m) {
+            size_t bit = size_t(__builtin_ctzll(m));
+            f(i + (bit >> 2));
+            m &= ~(uint64_t(0xF) << bit);
+        }
+    }
+#endif
+    for (; i < to; i++) {
+        if (buf[i] == '\n') f(i);
+    }
+}
+
+/* Whether the line starting at pos has content: anything but JSON
+ * whitespace before its newline (or the end of the buffer) */
+static inline bool line_has_content(const char* buf, size_t len, size_t pos) {
+    for (; pos < len && buf[pos] != '\n'; pos++) {
+        if (buf[pos] != ' ' && buf[pos] != '\t' && buf[pos] != '\r') return true;
+    }
+    return false;
+}
+
+/* ============================================================================
+ * Document Statistics Helpers
+ * ============================================================================ */
+
+/* One pass over the tape; counts and extents are taken from the words
+ * themselves since container counts saturate at 2^24 */
+static void tape_stats(const dom::document* doc, fj_tape_stats* out) {
+    struct level {
+        bool object;
+        uint64_t items;     /* Tape values directly inside, keys included */
+    };
+    std::vector<level> stack;
+
+    /* The root word points one past the closing root word */
+    const uint64_t* tape = doc->tape.get();
+    const size_t end = size_t(tape[0] & internal::JSON_VALUE_MASK);
+    out->tape_words = end;
+    for (size_t i = 1; i + 1 < end; i++) {
+        auto type = internal::tape_type(tape[i] >> 56);
+        if (type == internal::tape_type::END_ARRAY || type == internal::tape_type::END_OBJECT) {
+            level l = stack.back();
+            stack.pop_back();
+            if (l.object) {
+                out->largest_object = std::max(out->largest_object, l.items / 2);
+            } else {
+                out->largest_array = std::max(out->largest_array, l.items);
+            }
+            continue;
+        }
+
+        bool is_key = !stack.empty() && stack.back().object && stack.back().items % 2 == 0;
+        if (!stack.empty()) stack.back().items++;
+        switch (type) {
+            case internal::tape_type::START_ARRAY:
+            case internal::tape_type::START_OBJECT: {
+                bool object = type == internal::tape_type::START_OBJECT;
+                out->counts[object ? FJ_TYPE_OBJECT : FJ_TYPE_ARRAY]++;
+                stack.push_back(level{object, 0});
+                out->max_depth = std::max(out->max_depth, uint64_t(stack.size()));
+                break;
+            }
+            case internal::tape_type::STRING: {
+                size_t offset = size_t(tape[i] & internal::JSON_VALUE_MASK);
+                uint32_t len;
+                std::memcpy(&len, doc->string_buf.get() + offset, sizeof(len));
+                /* Length prefix, bytes, terminator */
+                out->string_bytes = std::max(out->string_bytes, uint64_t(offset) + sizeof(len) + len + 1);
+                if (is_key) {
+                    out->keys++;
+                } else {
+                    out->counts[FJ_TYPE_STRING]++;
+                }
+                break;
+            }
+            case internal::tape_type::INT64: out->counts[FJ_TYPE_INT64]++; i++; break;
+            case internal::tape_type::UINT64: out->counts[FJ_TYPE_UINT64]++; i++; break;
+            case internal::tape_type::DOUBLE: out->counts[FJ_TYPE_DOUBLE]++; i++; break;
+            case internal::tape_type::TRUE_VALUE:
+            case internal::tape_type::FALSE_VALUE: out->counts[FJ_TYPE_BOOL]++; break;
+            case internal::tape_type::NULL_VALUE: out->counts[FJ_TYPE_NULL]++; break;
+            default: break;
+        }
+    }
+}
+
+/*
+ * Bytes held while the document is alive: the document itself, the parser's
+ * tape and string buffer, stage 1 index, stage 2 stacks and padded input
+ * copy. Buffer sizes follow simdjson's allocation rules for the current
+ * capacities; the input copy is counted at full capacity, an upper bound.
+ */
+static uint64_t document_retained_bytes(const fj_document_s* d, const dom::document* doc) {
+    uint64_t bytes = sizeof(fj_document_s) + d->source_map.capacity() * sizeof(uint32_t);
+
+    size_t doc_capacity = doc->capacity();
+    if (doc_capacity) {
+        bytes += SIMDJSON_ROUNDUP_N(doc_capacity + 3, 64) * sizeof(uint64_t);
+        bytes += SIMDJSON_ROUNDUP_N(5 * doc_capacity / 3 + SIMDJSON_PADDING, 64);
+    }
+    if (d->parser) {
+        const dom::parser& parser = d->parser->parser;
+        size_t capacity = parser.capacity();
+        if (capacity) {
+            bytes += (SIMDJSON_ROUNDUP_N(capacity, 64) + 2 + 7) * sizeof(uint32_t);
+            bytes += capacity + SIMDJSON_PADDING;
+        }
+        /* open_container (8 bytes) and is_array flag per level */
+        bytes += parser.max_depth() * (8 + sizeof(bool));
+    }
+    return bytes;
+}
+
+/* ============================================================================
+ * JSONC Helpers
+ * ============================================================================ */
+
+/* Bitmasks of the bytes of a 64-byte block that JSONC stripping looks at */
+struct jsonc_block {
+    uint64_t quote;
+    uint64_t backslash;
+    uint64_t slash;
+    uint64_t closer;        /* ']' or '}' */
+};
+
+static inline jsonc_block jsonc_classify(const char* p, size_t n) {
+    char tmp[64];
+    if (n < 64) {
+        std::memset(tmp, ' ', sizeof(tmp));
+        std::memcpy(tmp, p, n);
+        p = tmp;
+    }
+    jsonc_block b;
+#if defined(__AVX2__)
+    auto mask = [p](auto&& eq) {
+        __m256i lo = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        __m256i hi = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + 32));
+        return uint64_t(uint32_t(_mm256_movemask_epi8(eq(lo)))) |
+               uint64_t(uint32_t(_mm256_movemask_epi8(eq(hi)))) << 32;
+    };
+    auto is = [](char c) {
+        return [c](__m256i v) { return _mm256_cmpeq_epi8(v, _mm256_set1_epi8(c)); };
+    };
+    b.quote = mask(is('"'));
+    b.backslash = mask(is('\\'));
+    b.slash = mask(is('/'));
+    b.closer = mask([](__m256i v) {
+        /* ']' and '}' differ only in bit 5 */
+        return _mm256_cmpeq_epi8(_mm256_or_si256(v, _mm256_set1_epi8(0x20)), _mm256_set1_epi8('}'));
+    });
+#elif defined(__SSE2__)
+    b.quote = b.backslash = b.slash = b.closer = 0;
+    for (int k = 0; k < 4; k++) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 16 * k));
+        __m128i closer = _mm_cmpeq_epi8(_mm_or_si128(v, _mm_set1_epi8(0x20)), _mm_set1_epi8('}'));
+        b.quote |= uint64_t(uint32_t(_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8('"'))))) << (16 * k);
+        b.backslash |= uint64_t(uint32_t(_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8('\\'))))) << (16 * k);
+        b.slash |= uint64_t(uint32_t(_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8('/'))))) << (16 * k);
+        b.closer |= uint64_t(uint32_t(_mm_movemask_epi8(closer))) << (16 * k);
+    }
+#elif defined(__ARM_NEON)
+    const uint8x16_t bit = {1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128};
+    uint8x16_t v[4];
+    for (int k = 0; k < 4; k++) v[k] = vld1q_u8(reinterpret_cast<const uint8_t*>(p + 16 * k));
+    auto mask = [&](auto&& eq) {
+        uint8x16_t s0 = vpaddq_u8(vandq_u8(eq(v[0]), bit), vandq_u8(eq(v[1]), bit));
+        uint8x16_t s1 = vpaddq_u8(vandq_u8(eq(v[2]), bit), vandq_u8(eq(v[3]), bit));
+        s0 = vpaddq_u8(s0, s1);
+        s0 = vpaddq_u8(s0, s0);
+        return vgetq_lane_u64(vreinterpretq_u64_u8(s0), 0);
+    };
+    auto is = [](char c) {
+        return [c](uint8x16_t x) { return vceqq_u8(x, vdupq_n_u8(uint8_t(c))); };
+    };
+    b.quote = mask(is('"'));
+    b.backslash = mask(is('\\'));
+    b.slash = mask(is('/'));
+    b.closer = mask([](uint8x16_t x) { return vceqq_u8(vorrq_u8(x, vdupq_n_u8(0x20)), vdupq_n_u8('}')); });
+#else
+    b.quote = b.backslash = b.slash = b.closer = 0;
+    for (size_t k = 0; k < 64; k++) {
+        uint64_t bit = uint64_t(1) << k;
+        if (p[k] == '"') b.quote |= bit;
+        if (p[k] == '\\') b.backslash |= bit;
+        if (p[k] == '/') b.slash |= bit;
+        if (p[k] == ']' || p[k] == '}') b.closer |= bit;
+    }
+#endif
+    return b;
+}
+
+/* Bits escaped by a backslash, carrying an odd run across blocks (as in
+ * simdjson's stage 1) */
+static inline uint64_t jsonc_escaped(uint64_t backslash, uint64_t& escape_carry) {
+    const uint64_t even_bits = 0x5555555555555555ULL;
+    backslash &= ~escape_carry;
+    uint64_t follows_escape = backslash << 1 | escape_carry;
+    uint64_t odd_starts = backslash & ~even_bits & ~follows_escape;
+    uint64_t even_starts;
+    escape_carry = __builtin_add_overflow(odd_starts, backslash, &even_starts) ? 1 : 0;
+    return (even_bits ^ (even_starts << 1)) & follows_escape;
+}
+
+/* Each bit set if an odd number of bits are set at or below it */
+static inline uint64_t prefix_xor(uint64_t x) {
+    x ^= x << 1;
+    x ^= x << 2;
+    x ^= x << 4;
+    x ^= x << 8;
+    x ^= x << 16;
+    x ^= x << 32;
+    return x;
+}
+
+static const size_t JSONC_UNCLOSED = std::numeric_limits<size_t>::max();
+
+/* End of the comment starting at pos: 0 if there is none, JSONC_UNCLOSED if
+ * a block comment runs off the end */
+static size_t jsonc_comment_end(const char* buf, size_t len, size_t pos) {
+    if (pos + 1 >= len || buf[pos] != '/') return 0;
+    if (buf[pos + 1] == '/') {
+        const void* nl = std::memchr(buf + pos + 2, '\n', len - pos - 2);
+        return nl ? size_t(static_cast<const char*>(nl) - buf) : len;
+    }
+    if (buf[pos + 1] != '*') return 0;
+    for (size_t i = pos + 2; i < len; i++) {
+        const void* star = std::memchr(buf + i, '*', len - i);
+        if (!star) break;
+        i = size_t(static_cast<const char*>(star) - buf);
+        if (i + 1 < len && buf[i + 1] == '/') return i + 2;
+    }
+    return JSONC_UNCLOSED;
+}
+
+/* Blank buf[from, to) but keep line breaks, so offsets and line numbers of
+ * the stripped text match the original */
+static void jsonc_blank(char* buf, size_t from, size_t to) {
+    for (size_t i = from; i < to; i++) {
+        if (buf[i] != '\n' && buf[i] != '\r') buf[i] = ' ';
+    }
+}
+
+/* Blank a comma that is the last thing before the closer at pos. Comments
+ * before pos are already blanked, so only whitespace has to be skipped. */
+static inline void jsonc_trailing_comma(char* buf, size_t pos) {
+    while (pos > 0) {
+        char c = buf[--pos];
+        if (c == ' ' || c == '\t' || c == '\r' || c == '\n') continue;
+        if (c == ',') buf[pos] = ' ';
+        return;
+    }
+}
+
+/* ============================================================================
+ * Numeric Array Helpers
+ * ============================================================================ */
+
+/* Elements of the array at tape index idx (the tape's count saturates) */
+static size_t tape_array_size(const dom::document* doc, size_t idx) {
+    internal::tape_ref t(doc, idx);
+    size_t n = t.scope_count();
+    if (n < internal::JSON_COUNT_MASK) return n;
+    n = 0;
+    const size_t end = t.matching_brace_index() - 1;
+    for (size_t i = idx + 1; i < end; i = internal::tape_ref(doc, i).after_element()) n++;
+    return n;
+}
+
+/*
+ * Shape of the nested array at idx, read along its first elements: depth
+ * levels, or while the first element is an array when depth is 0. Levels
+ * below an empty array are 0.
+ */
+static fj_error nested_shape(const dom::document* doc, size_t idx, size_t depth, fj_shape* shape) {
+    const size_t max_depth = sizeof(shape->dims) / sizeof(shape->dims[0]);
+    *shape = fj_shape();
+    if (depth > max_depth) return FJ_ERROR_DEPTH_ERROR;
+    
+    for (size_t level = 0; ; level++) {
+        if (internal::tape_ref(doc, idx).tape_ref_type() != internal::tape_type::START_ARRAY) {
+            return FJ_ERROR_INCORRECT_TYPE;
+        }
+        size_t n = tape_array_size(doc, idx);
+        shape->dims[level] = n;
+        shape->depth = level + 1;
+        idx++;
+        bool deeper = depth ? level + 1 < depth
+                            : n && internal::tape_ref(doc, idx).tape_ref_type() == internal::tape_type::START_ARRAY;
+        if (!deeper) return FJ_SUCCESS;
+        if (level + 1 == max_depth) return FJ_ERROR_DEPTH_ERROR;
+        if (n == 0) {
+            shape->depth = depth;
+            return FJ_SUCCESS;
+        }
+    }
+}
+
+/*
+ * Copy the numbers of a nested array of the given shape, row-major, in
+ * one pass along the tape: each level counts down its expected elements,
+ * so a row of another length or a non-number leaf stops the walk.
+ */
+template <typename T>
+static fj_error copy_nested_numbers(const dom::document* doc, size_t idx, const fj_shape& shape, T* out) {
+    size_t left[sizeof(shape.dims) / sizeof(shape.dims[0])];
+    const size_t leaf = shape.depth - 1;
+    size_t level = 0;
+    left[0] = shape.dims[0];
+    
+    for (size_t i = idx + 1; ; ) {
+        internal::tape_ref t(doc, i);
+        internal::tape_type type = t.tape_ref_type();
+        if (type == internal::tape_type::END_ARRAY) {
+            if (left[level]) return FJ_ERROR_INCORRECT_TYPE;
+            if (level-- == 0) return FJ_SUCCESS;
+            i++;
+            continue;
+        }
+        if (left[level] == 0) return FJ_ERROR_INCORRECT_TYPE;
+        left[level]--;
+        if (level < leaf) {
+            if (type != internal::tape_type::START_ARRAY) return FJ_ERROR_INCORRECT_TYPE;
+            level++;
+            left[level] = shape.dims[level];
+            i++;
+            continue;
+        }
+        switch (type) {
+            case internal::tape_type::INT64: *out++ = static_cast<T>(t.next_tape_value<int64_t>()); break;
+            case internal::tape_type::UINT64: *out++ = static_cast<T>(t.next_tape_value<uint64_t>()); break;
+            case internal::tape_type::DOUBLE: *out++ = static_cast<T>(t.next_tape_value<double>()); break;
+            default: return FJ_ERROR_INCORRECT_TYPE;
+        }
+        i += 2;
+    }
+}
+
+template <typename T>
+static fj_error copy_nested_array(const dom::element* e, size_t depth, T* out, size_t cap, fj_shape* shape) {
+    internal::tape_ref t = tape_of(e);
+    fj_error err = nested_shape(t.doc, t.json_index, depth, shape);
+    if (err != FJ_SUCCESS) return err;
+    
+    size_t total = 1;
+    for (size_t level = 0; level < shape->depth; level++) {
+        size_t n = shape->dims[level];
+        if (n && total > SIZE_MAX / n) return FJ_ERROR_CAPACITY;
+        total *= n;
+    }
+    if (total > cap) return FJ_ERROR_CAPACITY;
+    return copy_nested_numbers(t.doc, t.json_index, *shape, out);
+}
+
+/* ============================================================================
+ * Parser Functions
+ * ============================================================================ */
+
+extern "C" {
+
+fj_parser fj_parser_new(size_t max_capacity) {
+    try {
+        return new fj_parser_s(max_capacity);
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+void fj_parser_free(fj_parser p) {
+    delete p;
+}
+
+fj_error fj_parser_parse(fj_parser p, const char* json, size_t len, fj_document* doc) {
+    if (!p || !json || !doc) {
+        return FJ_ERROR_UNINITIALIZED;
+    }
+    
+    uint64_t started = parse_begin(json, len);
+    fj_error err = FJ_SUCCESS;
+    try {
+        size_t capacity = p->parser.capacity();
+        auto result = p->profiling || FJ_PROBE_ENABLED(parse__stage1) || FJ_PROBE_ENABLED(parse__stage2)
+                    ? parse_staged(p->parser, json, len, p->profiling ? &p->profile : nullptr)
+                    : p->parser.parse(json, len);
+        p->profiled |= p->profiling;
+        if (p->parser.capacity() != capacity) {
+            FJ_PROBE2(parser__grow, capacity, p->parser.capacity());
+        }
+        if (result.error()) {
+            *doc = nullptr;
+            err = map_error(result.error());
+        } else {
+            auto d = new fj_document_s();
+            d->root = result.value();
+            d->error = FJ_SUCCESS;
+            d->parser = p;
+            d->source = json;
+            d->source_len = len;
+            d->borrow_strings = p->borrow_strings;
+            if (len >= 3 && std::memcmp(json, "\xEF\xBB\xBF", 3) == 0) {
+                d->source += 3;
+                d->source_len -= 3;
+            }
+            *doc = d;
+        }
+    } catch (...) {
+        *doc = nullptr;
+        err = FJ_ERROR_UNEXPECTED_ERROR;
+    }
+    parse_end(started, len, err);
+    return err;
+}
+
+fj_error fj_parser_parse_padded(fj_parser p, const char* json, size_t len, fj_document* doc) {
+    /* For padded input, simdjson can skip the copy */
+    return fj_parser_parse(p, json, len, doc);
+}
+
+void fj_parser_set_profiling(fj_parser p, bool enabled) {
+    if (p) p->profiling = enabled;
+}
+
+void fj_parser_set_borrow_strings(fj_parser p, bool enabled) {
+    if (p) p->borrow_strings = enabled;
+}
+
+fj_error fj_parser_last_profile(fj_parser p, fj_parse_profile* out) {
+    if (!p || !out || !p->profiled) return FJ_ERROR_UNINITIALIZED;
+    *out = p->profile;
+    return FJ_SUCCESS;
+}
+
+/* ============================================================================
+ * Document Functions
+ * ============================================================================ */
+
+void fj_document_free(fj_document doc) {
+    delete doc;
+}
+
+fj_value fj_document_root(fj_document doc) {
+    fj_value v;
+    v.impl = doc ? reinterpret_cast<void*>(&doc->root) : nullptr;
+    v.doc = doc;
+    return v;
+}
+
+fj_error fj_document_error(fj_document doc) {
+    return doc ? doc->error : FJ_ERROR_UNINITIALIZED;
+}
+
+fj_error fj_document_stats(fj_document doc, fj_tape_stats* out) {
+    if (!doc || !out) return FJ_ERROR_UNINITIALIZED;
+    try {
+        const dom::document* d = tape_of(&doc->root).doc;
+        *out = fj_tape_stats();
+        tape_stats(d, out);
+        out->retained_bytes = document_retained_bytes(doc, d);
+        return FJ_SUCCESS;
+    } catch (...) {
+        return FJ_ERROR_MEMALLOC;
+    }
+}
+
+const char* fj_error_message(fj_error err) {
+    static const char* messages[] = {
+        "Success",
+        "Document too large",
+        "Memory allocation failed",
+        "Internal tape error",
+        "Document too deep",
+        "Invalid string",
+        "Invalid 'true' atom",
+        "Invalid 'false' atom",
+        "Invalid 'null' atom",
+        "Invalid number",
+        "Invalid UTF-8 encoding",
+        "Parser not initialized",
+        "Empty input",
+        "Unescaped control characters in string",
+        "Unclosed string",
+        "Unsupported architecture",
+        "Incorrect type",
+        "Number out of range",
+        "Array index out of bounds",
+        "Object field not found",
+        "I/O error",
+        "Invalid JSON pointer",
+        "Invalid URI fragment",
+        "Unexpected error",
+        "Parser already in use",
+        "Out of order iteration",
+        "Insufficient padding",
+        "Incomplete array or object",
+        "Scalar document as value",
+        "Out of bounds",
+        "Trailing content after JSON",
+        "Invalid JSON Patch operation",
+        "JSON Patch test failed",
+        "Invalid RFC 3339 timestamp",
+        "Invalid base64 or hex data",
+        "Unclosed comment"
+    };
+    
+    if (err == FJ_ERROR_UNKNOWN || err > FJ_ERROR_UNCLOSED_COMMENT) {
+        return "Unknown error";
+    }
+    return messages[err];
+}
+
+/* ============================================================================
+ * Value Type Functions
+ * ============================================================================ */
+
+static inline dom::element* get_element(fj_value v) {
+    return reinterpret_cast<dom::element*>(v.impl);
+}
+
+/* Id of the document whose tape holds v, or 0 (stream values, other tapes) */
+static inline uint64_t document_id(fj_value v) {
+    auto d = static_cast<const fj_document_s*>(v.doc);
+    return d && tape_of(&d->root).doc == tape_of(get_element(v)).doc ? d->id : 0;
+}
+
+fj_type fj_value_type(fj_value v) {
+    if (!v.impl) return FJ_TYPE_NULL;
+    return map_type(get_element(v)->type());
+}
+
+bool fj_value_is_null(fj_value v) {
+    return v.impl && get_element(v)->is_null();
+}
+
+bool fj_value_is_bool(fj_value v) {
+    return v.impl && get_element(v)->is_bool();
+}
+
+bool fj_value_is_int64(fj_value v) {
+    return v.impl && get_element(v)->is_int64();
+}
+
+bool fj_value_is_uint64(fj_value v) {
+    return v.impl && get_element(v)->is_uint64();
+}
+
+bool fj_value_is_double(fj_value v) {
+    return v.impl && get_element(v)->is_double();
+}
+
+bool fj_value_is_number(fj_value v) {
+    if (!v.impl) return false;
+    auto t = get_element(v)->type();
+    return t == dom::element_type::INT64 || 
+           t == dom::element_type::UINT64 || 
+           t == dom::element_type::DOUBLE;
+}
+
+bool fj_value_is_string(fj_value v) {
+    return v.impl && get_element(v)->is_string();
+}
+
+bool fj_value_is_array(fj_value v) {
+    return v.impl && get_element(v)->is_array();
+}
+
+bool fj_value_is_object(fj_value v) {
+    return v.impl && get_element(v)->is_object();
+}
+
+/* ============================================================================
+ * Value Extraction Functions
+ * ============================================================================ */
+
+fj_error fj_value_get_bool(fj_value v, bool* out) {
+    if (!v.impl || !out) return FJ_ERROR_UNINITIALIZED;
+    
+    auto result = get_element(v)->get_bool();
+    if (result.error()) return map_error(result.error());
+    *out = result.value();
+    return FJ_SUCCESS;
+}
+
+fj_error fj_value_get_int64(fj_value v, int64_t* out) {
+    if (!v.impl || !out) return FJ_ERROR_UNINITIALIZED;
+    
+    auto result = get_element(v)->get_int64();
+    if (result.error()) return map_error(result.error());
+    *out = result.value();
+    return FJ_SUCCESS;
+}
+
+fj_error fj_value_get_uint64(fj_value v, uint64_t* out) {
+    if (!v.impl || !out) return FJ_ERROR_UNINITIALIZED;
+    
+    auto result = get_element(v)->get_uint64();
+    if (result.error()) return map_error(result.error());
+    *out = result.value();
+    return FJ_SUCCESS;
+}
+
+fj_error fj_value_get_double(fj_value v, double* out) {
+    if (!v.impl || !out) return FJ_ERROR_UNINITIALIZED;
+    
+    auto result = get_element(v)->get_double();
+    if (result.error()) return map_error(result.error());
+    *out = result.value();
+    return FJ_SUCCESS;
+}
+
+fj_error fj_value_get_string(fj_value v, const char** out, size_t* len) {
+    if (!v.impl || !out || !len) return FJ_ERROR_UNINITIALIZED;
+    
+    auto result = get_element(v)->get_string();
+    if (result.error()) return map_error(result.error());
+    std::string_view sv = result.value();
+    *out = sv.data();
+    *len = sv.size();
+    auto d = static_cast<fj_document_s*>(v.doc);
+    if (d && d->borrow_strings) {
+        internal::tape_ref t = tape_of(get_element(v));
+        if (const char* raw = source_string(d, t.doc, t.json_index, sv.size())) *out = raw;
+    }
+    return FJ_SUCCESS;
+}
+
+fj_error fj_value_get_string_raw(fj_value v, const char** out, size_t* len) {
+    if (!v.impl || !out || !len) return FJ_ERROR_UNINITIALIZED;
+    
+    auto result = get_element(v)->get_string();
+    if (result.error()) return map_error(result.error());
+    auto d = static_cast<fj_document_s*>(v.doc);
+    if (!d) return FJ_ERROR_UNINITIALIZED;
+    internal::tape_ref t = tape_of(get_element(v));
+    size_t n = result.value_unsafe().size();
+    const char* raw = source_string_raw(d, t.doc, t.json_index, &n);
+    if (!raw) return FJ_ERROR_UNINITIALIZED;
+    *out = raw;
+    *len = n;
+    return FJ_SUCCESS;
+}
+
+fj_error fj_value_get_int64_lenient(fj_value v, int64_t* out) {
+    if (!v.impl || !out) return FJ_ERROR_UNINITIALIZED;
+    
+    const dom::element* e = get_element(v);
+    if (!e->is_string()) return fj_value_get_int64(v, out);
+    
+    std::string_view text = e->get_string().value_unsafe();
+    bool negative = !text.empty() && text[0] == '-';
+    uint64_t magnitude;
+    fj_error err = parse_decimal_digits(text.substr(negative), &magnitude);
+    if (err != FJ_SUCCESS) return err;
+    if (magnitude > uint64_t(std::numeric_limits<int64_t>::max()) + negative) {
+        return FJ_ERROR_NUMBER_OUT_OF_RANGE;
+    }
+    *out = negative ? int64_t(0 - magnitude) : int64_t(magnitude);
+    return FJ_SUCCESS;
+}
+
+fj_error fj_value_get_uint64_lenient(fj_value v, uint64_t* out) {
+    if (!v.impl || !out) return FJ_ERROR_UNINITIALIZED;
+    
+    const dom::element* e = get_element(v);
+    if (!e->is_string()) return fj_value_get_uint64(v, out);
+    
+    std::string_view text = e->get_string().value_unsafe();
+    if (!text.empty() && text[0] == '-') {
+        return is_json_number(text) ? FJ_ERROR_NUMBER_OUT_OF_RANGE : FJ_ERROR_NUMBER_ERROR;
+    }
+    return parse_decimal_digits(text, out);
+}
+
+fj_error fj_value_get_double_lenient(fj_value v, double* out) {
+    if (!v.impl || !out) return FJ_ERROR_UNINITIALIZED;
+    
+    const dom::element* e = get_element(v);
+    if (!e->is_string()) return fj_value_get_double(v, out);
+    
+    std::string_view text = e->get_string().value_unsafe();
+    if (!is_json_number(text)) return FJ_ERROR_NUMBER_ERROR;
+    
+    /* Validated above, so simdjson's own (unchecked) number parser applies */
+    double d = internal::from_chars(text.data(), text.data() + text.size());
+    if (!std::isfinite(d)) return FJ_ERROR_NUMBER_OUT_OF_RANGE;
+    *out = d;
+    return FJ_SUCCESS;
+}
+
+/* ============================================================================
+ * Object Access Functions
+ * ============================================================================ */
+
+fj_error fj_value_get_field(fj_value v, const char* key, fj_value* out) {
+    if (!v.impl || !key || !out) return FJ_ERROR_UNINITIALIZED;
+    
+    auto obj_result = get_element(v)->get_object();
+    if (obj_result.error()) return map_error(obj_result.error());
+    
+    auto field_result = obj_result.value()[key];
+    if (field_result.error()) return map_error(field_result.error());
+    
+    /* Store element in document's memory */
+    static thread_local dom::element stored_elements[256];
+    static thread_local size_t stored_idx = 0;
+    stored_idx = (stored_idx + 1) % 256;
+    stored_elements[stored_idx] = field_result.value();
+    
+    out->impl = &stored_elements[stored_idx];
+    out->doc = v.doc;
+    return FJ_SUCCESS;
 }
 
 fj_error fj_value_get_field_len(fj_value v, const char* key, size_t key_len, fj_value* out) {
     if (!v.impl || !key || !out) return FJ_ERROR_UNINITIALIZED;
     
     auto obj_result = get_element(v)->get_object();
-    if (obj_result.error()) return map_error(obj_result.error());
+    if (obj_result.error()) return map_error(obj_result.error());
+    
+    auto field_result = obj_result.value()[std::string_view(key, key_len)];
+    if (field_result.error()) return map_error(field_result.error());
+    
+    static thread_local dom::element stored_elements[256];
+    static thread_local size_t stored_idx = 0;
+    stored_idx = (stored_idx + 1) % 256;
+    stored_elements[stored_idx] = field_result.value();
+    
+    out->impl = &stored_elements[stored_idx];
+    out->doc = v.doc;
+    return FJ_SUCCESS;
+}
+
+fj_error fj_value_get_field_cached(fj_value v, const char* key, size_t key_len,
+                                   fj_field_slot* slot, fj_value* out) {
+    if (!v.impl || !key || !slot || !out) return FJ_ERROR_UNINITIALIZED;
+
+    internal::tape_ref obj = tape_of(get_element(v));
+    if (obj.tape_ref_type() != internal::tape_type::START_OBJECT) {
+        return FJ_ERROR_INCORRECT_TYPE;
+    }
+
+    size_t idx = tape_find_cached(obj, document_id(v), slot, key, key_len,
+                                  [key, key_len](const internal::tape_ref& k) {
+                                      return tape_key_equals(k, key, key_len);
+                                  });
+    if (idx == 0) return FJ_ERROR_NO_SUCH_FIELD;
+    out->impl = stash_element(element_at(obj.doc, idx));
+    out->doc = v.doc;
+    return FJ_SUCCESS;
+}
+
+void fj_key_init(fj_key* key, const char* name, size_t len) {
+    if (!key) return;
+    std::memset(key, 0, sizeof(*key));
+    key->name = name;
+    key->len = len;
+    size_t n = len < 16 ? len : 16;
+    unsigned char bytes[16] = {0};
+    unsigned char ones[16] = {0};
+    if (name) std::memcpy(bytes, name, n);
+    std::memset(ones, 0xFF, n);
+    std::memcpy(key->prefix, bytes, sizeof(bytes));
+    std::memcpy(key->mask, ones, sizeof(ones));
+}
+
+fj_error fj_value_get_field_key(fj_value v, fj_key* key, fj_value* out) {
+    if (!v.impl || !key || !key->name || !out) return FJ_ERROR_UNINITIALIZED;
+
+    internal::tape_ref obj = tape_of(get_element(v));
+    if (obj.tape_ref_type() != internal::tape_type::START_OBJECT) {
+        return FJ_ERROR_INCORRECT_TYPE;
+    }
+
+    size_t idx = tape_find_key(obj, document_id(v), key);
+    if (idx == 0) return FJ_ERROR_NO_SUCH_FIELD;
+    out->impl = stash_element(element_at(obj.doc, idx));
+    out->doc = v.doc;
+    return FJ_SUCCESS;
+}
+
+bool fj_value_has_field(fj_value v, const char* key) {
+    if (!v.impl || !key) return false;
+    
+    auto obj_result = get_element(v)->get_object();
+    if (obj_result.error()) return false;
     
-    auto field_result = obj_result.value()[std::string_view(key, key_len)];
-    if (field_result.error()) return map_error(field_result.error());
+    auto field_result = obj_result.value()[key];
+    return !field_result.error();
+}
+
+fj_error fj_value_object_size(fj_value v, size_t* out) {
+    if (!v.impl || !out) return FJ_ERROR_UNINITIALIZED;
+    
+    auto result = get_element(v)->get_object();
+    if (result.error()) return map_error(result.error());
+    *out = result.value().size();
+    return FJ_SUCCESS;
+}
+
+/* ============================================================================
+ * Array Access Functions
+ * ============================================================================ */
+
+fj_error fj_value_get_index(fj_value v, size_t idx, fj_value* out) {
+    if (!v.impl || !out) return FJ_ERROR_UNINITIALIZED;
+    
+    auto arr_result = get_element(v)->get_array();
+    if (arr_result.error()) return map_error(arr_result.error());
+    
+    auto elem_result = arr_result.value().at(idx);
+    if (elem_result.error()) return map_error(elem_result.error());
+    
+    static thread_local dom::element stored_elements[256];
+    static thread_local size_t stored_idx = 0;
+    stored_idx = (stored_idx + 1) % 256;
+    stored_elements[stored_idx] = elem_result.value();
+    
+    out->impl = &stored_elements[stored_idx];
+    out->doc = v.doc;
+    return FJ_SUCCESS;
+}
+
+fj_error fj_value_array_size(fj_value v, size_t* out) {
+    if (!v.impl || !out) return FJ_ERROR_UNINITIALIZED;
+    
+    auto result = get_element(v)->get_array();
+    if (result.error()) return map_error(result.error());
+    *out = result.value().size();
+    return FJ_SUCCESS;
+}
+
+fj_error fj_array_copy_doubles_nested(fj_value v, size_t depth, double* out, size_t cap, fj_shape* shape) {
+    if (!v.impl || !shape || (!out && cap)) return FJ_ERROR_UNINITIALIZED;
+    return copy_nested_array(get_element(v), depth, out, cap, shape);
+}
+
+fj_error fj_array_copy_floats_nested(fj_value v, size_t depth, float* out, size_t cap, fj_shape* shape) {
+    if (!v.impl || !shape || (!out && cap)) return FJ_ERROR_UNINITIALIZED;
+    return copy_nested_array(get_element(v), depth, out, cap, shape);
+}
+
+/* ============================================================================
+ * Iteration Functions
+ * ============================================================================ */
+
+fj_error fj_array_iter_new(fj_value v, fj_array_iter* iter) {
+    if (!v.impl || !iter) return FJ_ERROR_UNINITIALIZED;
+    
+    auto result = get_element(v)->get_array();
+    if (result.error()) return map_error(result.error());
+    
+    try {
+        *iter = new fj_array_iter_s(result.value(), v.doc);
+        return FJ_SUCCESS;
+    } catch (...) {
+        return FJ_ERROR_MEMALLOC;
+    }
+}
+
+bool fj_array_iter_next(fj_array_iter iter, fj_value* out) {
+    if (!iter || !out) return false;
+    
+    if (iter->current == iter->end) return false;
+    
+    static thread_local dom::element stored_elements[256];
+    static thread_local size_t stored_idx = 0;
+    stored_idx = (stored_idx + 1) % 256;
+    stored_elements[stored_idx] = *iter->current;
+    
+    out->impl = &stored_elements[stored_idx];
+    out->doc = iter->doc;
+    
+    ++iter->current;
+    return true;
+}
+
+void fj_array_iter_free(fj_array_iter iter) {
+    delete iter;
+}
+
+fj_error fj_object_iter_new(fj_value v, fj_object_iter* iter) {
+    if (!v.impl || !iter) return FJ_ERROR_UNINITIALIZED;
+    
+    auto result = get_element(v)->get_object();
+    if (result.error()) return map_error(result.error());
+    
+    try {
+        *iter = new fj_object_iter_s(result.value(), v.doc);
+        return FJ_SUCCESS;
+    } catch (...) {
+        return FJ_ERROR_MEMALLOC;
+    }
+}
+
+bool fj_object_iter_next(fj_object_iter iter, const char** key, size_t* key_len, fj_value* val) {
+    if (!iter || !key || !key_len || !val) return false;
+    
+    if (iter->current == iter->end) return false;
+    
+    auto field = *iter->current;
+    std::string_view k = field.key;
+    *key = k.data();
+    *key_len = k.size();
+    auto d = static_cast<fj_document_s*>(iter->doc);
+    if (d && d->borrow_strings) {
+        /* The key sits one tape word before its value */
+        internal::tape_ref t = tape_of(&field.value);
+        if (const char* raw = source_string(d, t.doc, t.json_index - 1, k.size())) *key = raw;
+    }
+    
+    static thread_local dom::element stored_elements[256];
+    static thread_local size_t stored_idx = 0;
+    stored_idx = (stored_idx + 1) % 256;
+    stored_elements[stored_idx] = field.value;
+    
+    val->impl = &stored_elements[stored_idx];
+    val->doc = iter->doc;
+    
+    ++iter->current;
+    return true;
+}
+
+void fj_object_iter_free(fj_object_iter iter) {
+    delete iter;
+}
+
+/* ============================================================================
+ * Serialization Functions
+ * ============================================================================ */
+
+fj_error fj_value_canonicalize(fj_value v, const fj_sink* sink) {
+    if (!v.impl || !sink || !sink->write) return FJ_ERROR_UNINITIALIZED;
+    
+    try {
+        internal::tape_ref t = tape_of(get_element(v));
+        std::vector<size_t> scratch;
+        sink_buffer out(sink);
+        write_canonical(out, t.doc, t.json_index, scratch);
+        return out.flush() ? FJ_SUCCESS : FJ_ERROR_IO_ERROR;
+    } catch (...) {
+        return FJ_ERROR_MEMALLOC;
+    }
+}
+
+size_t fj_format_double(double value, char* out) {
+    if (!out || !std::isfinite(value)) return 0;
+    return format_es_double(value, out);
+}
+
+/* ============================================================================
+ * Diff Functions
+ * ============================================================================ */
+
+fj_error fj_diff(fj_value a, fj_value b, const fj_sink* sink) {
+    if (!a.impl || !b.impl || !sink || !sink->write) return FJ_ERROR_UNINITIALIZED;
+    
+    try {
+        internal::tape_ref ta = tape_of(get_element(a));
+        internal::tape_ref tb = tape_of(get_element(b));
+        sink_buffer out(sink);
+        patch_writer writer = { &out, true };
+        tape_differ differ(ta.doc, tb.doc, emit_patch_op, &writer);
+        out.put('[');
+        differ.diff(ta.json_index, tb.json_index);
+        out.put(']');
+        return out.flush() ? FJ_SUCCESS : FJ_ERROR_IO_ERROR;
+    } catch (...) {
+        return FJ_ERROR_MEMALLOC;
+    }
+}
+
+struct diff_callback_ctx {
+    fj_diff_callback callback;
+    void* ctx;
+};
+
+static bool emit_diff_callback(void* ctx, fj_diff_op op, const std::string& path,
+                               const dom::document* da, size_t ai,
+                               const dom::document* db, size_t bi) {
+    diff_callback_ctx* c = static_cast<diff_callback_ctx*>(ctx);
+    fj_value old_value = { nullptr, nullptr };
+    fj_value new_value = { nullptr, nullptr };
+    if (ai) old_value.impl = stash_element(element_at(da, ai));
+    if (bi) new_value.impl = stash_element(element_at(db, bi));
+    return c->callback(c->ctx, op, path.data(), path.size(), old_value, new_value);
+}
+
+fj_error fj_diff_each(fj_value a, fj_value b, fj_diff_callback callback, void* ctx) {
+    if (!a.impl || !b.impl || !callback) return FJ_ERROR_UNINITIALIZED;
+    
+    try {
+        internal::tape_ref ta = tape_of(get_element(a));
+        internal::tape_ref tb = tape_of(get_element(b));
+        diff_callback_ctx c = { callback, ctx };
+        tape_differ differ(ta.doc, tb.doc, emit_diff_callback, &c);
+        differ.diff(ta.json_index, tb.json_index);
+        return FJ_SUCCESS;
+    } catch (...) {
+        return FJ_ERROR_MEMALLOC;
+    }
+}
+
+/* ============================================================================
+ * Patch Functions
+ * ============================================================================ */
+
+fj_error fj_apply_patch(fj_document doc, const char* patch, size_t patch_len, const fj_sink* sink) {
+    return patch_run(doc, patch, patch_len, sink, false);
+}
+
+fj_error fj_apply_merge_patch(fj_document doc, const char* patch, size_t patch_len, const fj_sink* sink) {
+    return patch_run(doc, patch, patch_len, sink, true);
+}
+
+/* ============================================================================
+ * Mutable Document Functions
+ * ============================================================================ */
+
+fj_error fj_mutable_new(fj_document doc, fj_mutable* out) {
+    if (!doc || !out) return FJ_ERROR_UNINITIALIZED;
+    *out = nullptr;
+    
+    try {
+        *out = new fj_mutable_s(doc);
+        return FJ_SUCCESS;
+    } catch (...) {
+        return FJ_ERROR_MEMALLOC;
+    }
+}
+
+void fj_mutable_free(fj_mutable m) {
+    delete m;
+}
+
+static fj_error mutable_store(fj_mutable m, const char* path, size_t path_len,
+                              const char* json, size_t json_len, bool insert) {
+    if (!m || !path || !json) return FJ_ERROR_UNINITIALIZED;
+    
+    try {
+        std::vector<std::string> tokens;
+        fj_error err = pointer_split(path, path_len, tokens);
+        if (err != FJ_SUCCESS) return err;
+        edit_ref value;
+        err = m->tree.fragment(json, json_len, &value);
+        if (err != FJ_SUCCESS) return err;
+        return insert ? m->tree.add(tokens, value) : m->tree.set(tokens, value);
+    } catch (...) {
+        return FJ_ERROR_MEMALLOC;
+    }
+}
+
+fj_error fj_mutable_set(fj_mutable m, const char* path, size_t path_len,
+                        const char* json, size_t json_len) {
+    return mutable_store(m, path, path_len, json, json_len, false);
+}
+
+fj_error fj_mutable_insert(fj_mutable m, const char* path, size_t path_len,
+                           const char* json, size_t json_len) {
+    return mutable_store(m, path, path_len, json, json_len, true);
+}
+
+fj_error fj_mutable_remove(fj_mutable m, const char* path, size_t path_len) {
+    if (!m || !path) return FJ_ERROR_UNINITIALIZED;
+    
+    try {
+        std::vector<std::string> tokens;
+        fj_error err = pointer_split(path, path_len, tokens);
+        if (err != FJ_SUCCESS) return err;
+        return m->tree.remove(tokens, nullptr);
+    } catch (...) {
+        return FJ_ERROR_MEMALLOC;
+    }
+}
+
+fj_error fj_mutable_get(fj_mutable m, const char* path, size_t path_len, fj_value* out) {
+    if (!m || !path || !out) return FJ_ERROR_UNINITIALIZED;
+    
+    try {
+        std::vector<std::string> tokens;
+        fj_error err = pointer_split(path, path_len, tokens);
+        if (err != FJ_SUCCESS) return err;
+        edit_ref found;
+        err = m->tree.lookup(tokens, &found);
+        if (err == FJ_SUCCESS) err = m->tree.freeze(found, &found);
+        if (err != FJ_SUCCESS) return err;
+        out->impl = stash_element(element_at(found.doc, found.idx));
+        /* Fragments and patch values have no input text in the base */
+        out->doc = m->tree.in_base(found) ? m->base : nullptr;
+        return FJ_SUCCESS;
+    } catch (...) {
+        return FJ_ERROR_MEMALLOC;
+    }
+}
+
+fj_error fj_mutable_serialize(fj_mutable m, const fj_sink* sink) {
+    if (!m || !sink || !sink->write) return FJ_ERROR_UNINITIALIZED;
+    
+    try {
+        sink_buffer out(sink);
+        m->tree.write(out, m->tree.root);
+        return out.flush() ? FJ_SUCCESS : FJ_ERROR_IO_ERROR;
+    } catch (...) {
+        return FJ_ERROR_MEMALLOC;
+    }
+}
+
+/* ============================================================================
+ * Streaming Functions
+ * ============================================================================ */
+
+static fj_error stream_open(fj_parser p, const char* json, size_t len, size_t batch_size,
+                            bool padded, fj_stream* stream) {
+    if (!p || !json || !stream) return FJ_ERROR_UNINITIALIZED;
+    *stream = nullptr;
+    
+    try {
+        std::unique_ptr<fj_stream_s> s(new fj_stream_s());
+        const char* buf = json;
+        if (!padded) {
+            s->owned.reset(new char[len + SIMDJSON_PADDING]);
+            std::memcpy(s->owned.get(), json, len);
+            std::memset(s->owned.get() + len, 0, SIMDJSON_PADDING);
+            buf = s->owned.get();
+        }
+        if (batch_size == 0) batch_size = dom::DEFAULT_BATCH_SIZE;
+        
+        auto err = p->parser.parse_many(buf, len, batch_size).get(s->docs);
+        if (err) return map_error(err);
+        s->parser = p;
+        s->buf = buf;
+        s->len = len;
+        s->batch_size = batch_size < dom::MINIMAL_BATCH_SIZE ? dom::MINIMAL_BATCH_SIZE : batch_size;
+        *stream = s.release();
+        metrics_stream_open(len);
+        FJ_PROBE2(stream__open, len, batch_size);
+        return FJ_SUCCESS;
+    } catch (...) {
+        return FJ_ERROR_MEMALLOC;
+    }
+}
+
+fj_error fj_parser_parse_many(fj_parser p, const char* json, size_t len, size_t batch_size,
+                              fj_stream* stream) {
+    return stream_open(p, json, len, batch_size, false, stream);
+}
+
+fj_error fj_parser_parse_many_padded(fj_parser p, const char* json, size_t len, size_t batch_size,
+                                     fj_stream* stream) {
+    return stream_open(p, json, len, batch_size, true, stream);
+}
+
+/* Smallest batch indexed again after a rejected record */
+static const size_t FJ_RESYNC_MIN_BATCH = 64 * 1024;
+
+static inline bool stream_is_space(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+/* Offset of the '\n' ending the line that contains pos, or len */
+static size_t stream_line_end(const fj_stream_s* s, size_t pos) {
+    const void* nl = std::memchr(s->buf + pos, '\n', s->len - pos);
+    return nl ? size_t(static_cast<const char*>(nl) - s->buf) : s->len;
+}
+
+/* Whether p[0..n) holds an even number of unescaped quotes, i.e. stage 1's
+ * in-string mask is still in phase after skipping it */
+static bool stream_quotes_balanced(const char* p, size_t n) {
+    bool open = false;
+    for (size_t i = 0; i < n; i++) {
+        if (p[i] == '\\') {
+            i++;
+        } else if (p[i] == '"') {
+            open = !open;
+        }
+    }
+    return !open;
+}
+
+/* Report the record [offset, end) to the callback or the dead-letter queue */
+static void stream_reject(fj_stream_s* s, size_t offset, size_t end, fj_error err) {
+    while (end > offset && stream_is_space(s->buf[end - 1])) end--;
+    fj_rejected_record r;
+    r.offset = offset;
+    r.length = end - offset;
+    r.text = s->buf + offset;
+    r.error = err;
+    s->rejected++;
+    metrics_stream_rejected();
+    if (s->on_reject) {
+        s->on_reject(s->on_reject_ctx, &r);
+    } else {
+        s->dead_letters.push_back(r);
+    }
+}
+
+/* Restart batching at pos. The window tracks the distance between errors,
+ * so dense errors never re-index much more input than they skip. */
+static void stream_resync(fj_stream_s* s, size_t pos) {
+    size_t gap = pos - s->last_resync;
+    s->last_resync = pos;
+    s->window = std::min(s->batch_size, std::max(FJ_RESYNC_MIN_BATCH, 2 * gap));
+    s->batch_start = pos;
+    s->batch_loaded = false;
+    s->lines_pos = s->lines_end = 0;
+}
+
+/* Parse [from, to) one line at a time */
+static void stream_fall_back_to_lines(fj_stream_s* s, size_t from, size_t to) {
+    s->batch_loaded = false;
+    s->lines_pos = from;
+    s->lines_end = to;
+    s->batch_start = to;
+}
+
+/* Run stage 1 over the next window of input */
+static void stream_load_batch(fj_stream_s* s) {
+    internal::dom_parser_implementation& impl = *s->parser->parser.implementation;
     
-    static thread_local dom::element stored_elements[256];
-    static thread_local size_t stored_idx = 0;
-    stored_idx = (stored_idx + 1) % 256;
-    stored_elements[stored_idx] = field_result.value();
+    while (s->batch_start < s->len) {
+        size_t remaining = s->len - s->batch_start;
+        bool final = remaining <= s->window;
+        size_t n = final ? remaining : s->window;
+        error_code err = impl.stage1(reinterpret_cast<const uint8_t*>(s->buf + s->batch_start), n,
+                                     final ? stage1_mode::streaming_final
+                                           : stage1_mode::streaming_partial);
+        FJ_PROBE3(stream__batch, s->batch_start, n, int(err));
+        const uint32_t* si = impl.structural_indexes.get();
+        
+        if (err == SUCCESS) {
+            s->batch_loaded = true;
+            s->batch_final = final;
+            /* A final batch keeps an incomplete trailing record out of the index */
+            s->batch_next = final ? s->batch_start + si[impl.n_structural_indexes + 1]
+                                  : s->batch_start + si[impl.n_structural_indexes];
+            return;
+        }
+        if (err == EMPTY) {
+            if (final) {
+                /* Whitespace, or nothing but an incomplete record */
+                stream_fall_back_to_lines(s, s->batch_start + si[1], s->len);
+                return;
+            }
+            if (si[0] > 0) {
+                s->batch_start += si[0];
+                continue;
+            }
+        }
+        
+        /* The window failed as a whole (invalid UTF-8, a control character,
+         * a record larger than the window): find the culprit line by line */
+        size_t end = stream_line_end(s, s->batch_start + n - 1);
+        stream_fall_back_to_lines(s, s->batch_start, end < s->len ? end + 1 : end);
+        return;
+    }
+}
+
+/* Next document of a tolerant stream; false at the end of the input */
+static bool stream_next_tolerant(fj_stream_s* s) {
+    dom::parser& parser = s->parser->parser;
     
-    out->impl = &stored_elements[stored_idx];
-    out->doc = v.doc;
-    return FJ_SUCCESS;
+    for (;;) {
+        if (s->lines_pos < s->lines_end) {
+            size_t start = s->lines_pos;
+            while (start < s->lines_end && stream_is_space(s->buf[start])) start++;
+            if (start >= s->lines_end) {
+                s->lines_pos = s->lines_end;
+                continue;
+            }
+            size_t end = stream_line_end(s, start);
+            s->lines_pos = end < s->len ? end + 1 : end;
+            
+            auto err = parser.parse(s->buf + start, end - start, false).get(s->current);
+            if (!err) {
+                s->doc_offset = start;
+                return true;
+            }
+            if (end == s->len) {
+                /* An unterminated last line may just be cut short */
+                s->truncated = end - start;
+                s->lines_pos = s->lines_end;
+                continue;
+            }
+            stream_reject(s, start, end, map_error(err));
+            /* The culprit is found: go back to batches */
+            if (s->lines_pos < s->lines_end) stream_resync(s, s->lines_pos);
+            continue;
+        }
+        
+        if (!s->batch_loaded) {
+            if (s->batch_start >= s->len) return false;
+            stream_load_batch(s);
+            continue;
+        }
+        
+        internal::dom_parser_implementation& impl = *parser.implementation;
+        if (impl.next_structural_index >= impl.n_structural_indexes) {
+            s->batch_loaded = false;
+            s->window = std::min(s->batch_size, s->window * 2);
+            if (s->batch_final) {
+                stream_fall_back_to_lines(s, s->batch_next, s->len);
+            } else {
+                s->batch_start = s->batch_next;
+            }
+            continue;
+        }
+        
+        size_t doc_start = s->batch_start + impl.structural_indexes[impl.next_structural_index];
+        error_code err = impl.stage2_next(parser.doc);
+        if (!err) {
+            s->current = parser.doc.root();
+            s->doc_offset = doc_start;
+            return true;
+        }
+        if (err == EMPTY) {
+            impl.next_structural_index = impl.n_structural_indexes;
+            continue;
+        }
+        
+        /* Bad record: reject it through the end of its line, then skip the
+         * line's structurals, or index again if they may be out of phase */
+        size_t end = stream_line_end(s, doc_start);
+        if (end == s->len) {
+            s->truncated = end - doc_start;
+            s->batch_loaded = false;
+            s->batch_start = s->len;
+            continue;
+        }
+        stream_reject(s, doc_start, end, map_error(err));
+        size_t resume = end + 1;
+        if (resume < s->batch_next && stream_quotes_balanced(s->buf + doc_start, resume - doc_start)) {
+            const uint32_t* si = impl.structural_indexes.get();
+            const uint32_t* next = std::lower_bound(si, si + impl.n_structural_indexes,
+                                                    uint32_t(resume - s->batch_start));
+            impl.next_structural_index = uint32_t(next - si);
+        } else {
+            stream_resync(s, resume);
+        }
+    }
 }
 
-bool fj_value_has_field(fj_value v, const char* key) {
-    if (!v.impl || !key) return false;
+bool fj_stream_next(fj_stream s, fj_value* out, fj_error* err) {
+    if (err) *err = FJ_SUCCESS;
+    if (!s || !out) {
+        if (err) *err = FJ_ERROR_UNINITIALIZED;
+        return false;
+    }
+    if (s->finished) return false;
     
-    auto obj_result = get_element(v)->get_object();
-    if (obj_result.error()) return false;
+    if (s->tolerant) {
+        s->started = true;
+        try {
+            if (!stream_next_tolerant(s)) {
+                s->finished = true;
+                return false;
+            }
+        } catch (...) {
+            s->finished = true;
+            if (err) *err = FJ_ERROR_MEMALLOC;
+            return false;
+        }
+        metrics_stream_document();
+        out->impl = &s->current;
+        out->doc = nullptr;
+        return true;
+    }
     
-    auto field_result = obj_result.value()[key];
-    return !field_result.error();
+    if (!s->started) {
+        s->it = s->docs.begin();
+        s->started = true;
+    } else {
+        ++s->it;
+    }
+    if (!(s->it != s->docs.end())) {
+        s->finished = true;
+        return false;
+    }
+    
+    auto result = *s->it;
+    if (result.error()) {
+        s->finished = true;
+        metrics_stream_error(map_error(result.error()));
+        if (err) *err = map_error(result.error());
+        return false;
+    }
+    metrics_stream_document();
+    s->current = result.value();
+    out->impl = &s->current;
+    out->doc = nullptr;
+    return true;
 }
 
-fj_error fj_value_object_size(fj_value v, size_t* out) {
-    if (!v.impl || !out) return FJ_ERROR_UNINITIALIZED;
+size_t fj_stream_current_offset(fj_stream s) {
+    if (!s || !s->started) return 0;
+    if (s->tolerant) return s->doc_offset;
+    return s->it.current_index();
+}
+
+size_t fj_stream_truncated_bytes(fj_stream s) {
+    if (!s || !s->finished) return 0;
+    if (s->tolerant) return s->truncated;
+    return s->docs.truncated_bytes();
+}
+
+fj_error fj_stream_set_tolerant(fj_stream s, fj_record_error_callback callback, void* ctx) {
+    if (!s || !s->parser) return FJ_ERROR_UNINITIALIZED;
+    if (s->started) return FJ_ERROR_OUT_OF_ORDER_ITERATION;
     
-    auto result = get_element(v)->get_object();
-    if (result.error()) return map_error(result.error());
-    *out = result.value().size();
+    /* Batches are parsed straight into the parser's own document */
+    dom::parser& parser = s->parser->parser;
+    if (s->batch_size > parser.max_capacity()) return FJ_ERROR_CAPACITY;
+    error_code err = SUCCESS;
+    if (parser.doc.capacity() < s->batch_size) err = parser.doc.allocate(s->batch_size);
+    if (!err && parser.capacity() < s->batch_size) err = parser.allocate(s->batch_size, parser.max_depth());
+    if (err) return map_error(err);
+    s->tolerant = true;
+    s->on_reject = callback;
+    s->on_reject_ctx = ctx;
+    s->window = s->batch_size;
     return FJ_SUCCESS;
 }
 
+size_t fj_stream_rejected_count(fj_stream s) {
+    return s ? s->rejected : 0;
+}
+
+bool fj_stream_next_rejected(fj_stream s, fj_rejected_record* out) {
+    if (!s || !out || s->dead_letters.empty()) return false;
+    *out = s->dead_letters.front();
+    s->dead_letters.pop_front();
+    return true;
+}
+
+void fj_stream_free(fj_stream s) {
+    delete s;
+}
+
 /* ============================================================================
- * Array Access Functions
+ * Path Functions
  * ============================================================================ */
 
-fj_error fj_value_get_index(fj_value v, size_t idx, fj_value* out) {
-    if (!v.impl || !out) return FJ_ERROR_UNINITIALIZED;
+fj_error fj_path_compile(const char* path, size_t len, fj_path* out) {
+    if (!path || !out) return FJ_ERROR_UNINITIALIZED;
+    *out = nullptr;
     
-    auto arr_result = get_element(v)->get_array();
-    if (arr_result.error()) return map_error(arr_result.error());
-    
-    auto elem_result = arr_result.value().at(idx);
-    if (elem_result.error()) return map_error(elem_result.error());
-    
-    static thread_local dom::element stored_elements[256];
-    static thread_local size_t stored_idx = 0;
-    stored_idx = (stored_idx + 1) % 256;
-    stored_elements[stored_idx] = elem_result.value();
-    
-    out->impl = &stored_elements[stored_idx];
-    out->doc = v.doc;
-    return FJ_SUCCESS;
+    try {
+        std::unique_ptr<fj_path_s> p(new fj_path_s());
+        fj_error err = path_compile(path, len, p.get());
+        if (err != FJ_SUCCESS) return err;
+        *out = p.release();
+        return FJ_SUCCESS;
+    } catch (...) {
+        return FJ_ERROR_MEMALLOC;
+    }
 }
 
-fj_error fj_value_array_size(fj_value v, size_t* out) {
-    if (!v.impl || !out) return FJ_ERROR_UNINITIALIZED;
+void fj_path_free(fj_path path) {
+    delete path;
+}
+
+fj_error fj_value_at_path(fj_value v, fj_path path, fj_value* out) {
+    if (!v.impl || !path || !out) return FJ_ERROR_UNINITIALIZED;
     
-    auto result = get_element(v)->get_array();
-    if (result.error()) return map_error(result.error());
-    *out = result.value().size();
+    internal::tape_ref t = tape_of(get_element(v));
+    size_t idx;
+    fj_error err = path_walk(t.doc, document_id(v), t.json_index, path, &idx);
+    if (err != FJ_SUCCESS) return err;
+    
+    out->impl = stash_element(element_at(t.doc, idx));
+    out->doc = v.doc;
     return FJ_SUCCESS;
 }
 
 /* ============================================================================
- * Iteration Functions
+ * Aggregation Functions
  * ============================================================================ */
 
-fj_error fj_array_iter_new(fj_value v, fj_array_iter* iter) {
-    if (!v.impl || !iter) return FJ_ERROR_UNINITIALIZED;
+fj_error fj_agg_new(const char* value_path, size_t value_path_len,
+                    const char* group_path, size_t group_path_len, fj_agg* out) {
+    if (!value_path || !out) return FJ_ERROR_UNINITIALIZED;
+    *out = nullptr;
     
-    auto result = get_element(v)->get_array();
-    if (result.error()) return map_error(result.error());
+    try {
+        std::unique_ptr<fj_agg_s> agg(new fj_agg_s());
+        fj_error err = path_compile(value_path, value_path_len, &agg->value_path);
+        if (err != FJ_SUCCESS) return err;
+        if (group_path) {
+            err = path_compile(group_path, group_path_len, &agg->group_path);
+            if (err != FJ_SUCCESS) return err;
+            agg->grouped = true;
+        }
+        *out = agg.release();
+        return FJ_SUCCESS;
+    } catch (...) {
+        return FJ_ERROR_MEMALLOC;
+    }
+}
+
+void fj_agg_free(fj_agg agg) {
+    delete agg;
+}
+
+void fj_agg_reset(fj_agg agg) {
+    if (!agg) return;
+    agg->groups.clear();
+    agg->table.clear();
+    agg->skipped = 0;
+}
+
+fj_error fj_agg_add(fj_agg agg, fj_value v) {
+    if (!agg || !v.impl) return FJ_ERROR_UNINITIALIZED;
     
     try {
-        *iter = new fj_array_iter_s(result.value());
+        internal::tape_ref t = tape_of(get_element(v));
+        agg_add(agg, t.doc, document_id(v), t.json_index);
         return FJ_SUCCESS;
     } catch (...) {
         return FJ_ERROR_MEMALLOC;
     }
 }
 
-bool fj_array_iter_next(fj_array_iter iter, fj_value* out) {
-    if (!iter || !out) return false;
+fj_error fj_agg_consume(fj_agg agg, fj_stream stream) {
+    if (!agg || !stream) return FJ_ERROR_UNINITIALIZED;
     
-    if (iter->current == iter->end) return false;
+    try {
+        fj_value v;
+        fj_error err;
+        while (fj_stream_next(stream, &v, &err)) {
+            internal::tape_ref t = tape_of(&stream->current);
+            agg_add(agg, t.doc, 0, t.json_index);
+        }
+        return err;
+    } catch (...) {
+        return FJ_ERROR_MEMALLOC;
+    }
+}
+
+size_t fj_agg_group_count(fj_agg agg) {
+    return agg ? agg->groups.size() : 0;
+}
+
+uint64_t fj_agg_skipped(fj_agg agg) {
+    return agg ? agg->skipped : 0;
+}
+
+fj_error fj_agg_group(fj_agg agg, size_t idx, const char** key, size_t* key_len,
+                      fj_agg_stats* stats) {
+    if (!agg || !key || !key_len || !stats) return FJ_ERROR_UNINITIALIZED;
+    if (idx >= agg->groups.size()) return FJ_ERROR_INDEX_OUT_OF_BOUNDS;
     
-    static thread_local dom::element stored_elements[256];
-    static thread_local size_t stored_idx = 0;
-    stored_idx = (stored_idx + 1) % 256;
-    stored_elements[stored_idx] = *iter->current;
+    const agg_group* g = agg->groups[idx].get();
+    *key = g->key.data();
+    *key_len = g->key.size();
+    stats->count = g->count;
+    stats->numeric_count = g->numeric_count;
+    stats->sum = g->sum;
+    stats->min = g->numeric_count ? g->min : 0;
+    stats->max = g->numeric_count ? g->max : 0;
+    stats->mean = g->numeric_count ? g->sum / static_cast<double>(g->numeric_count) : 0;
+    stats->distinct = hll_estimate(g->hll);
+    return FJ_SUCCESS;
+}
+
+/* ============================================================================
+ * UTF-8 Functions
+ * ============================================================================ */
+
+/* Sequence length announced by a lead byte (1 for anything invalid) */
+static inline size_t utf8_sequence_length(uint8_t lead) {
+    if (lead >= 0xF0 && lead < 0xF8) return 4;
+    if (lead >= 0xE0 && lead < 0xF0) return 3;
+    if (lead >= 0xC0 && lead < 0xE0) return 2;
+    return 1;
+}
+
+fj_error fj_validate_utf8(const char* buf, size_t len) {
+    if (!buf && len > 0) return FJ_ERROR_UNINITIALIZED;
+    return len == 0 || validate_utf8(buf, len) ? FJ_SUCCESS : FJ_ERROR_UTF8_ERROR;
+}
+
+void fj_utf8_init(fj_utf8_state* state) {
+    if (state) std::memset(state, 0, sizeof(*state));
+}
+
+fj_error fj_utf8_update(fj_utf8_state* state, const char* buf, size_t len) {
+    if (!state || (!buf && len > 0)) return FJ_ERROR_UNINITIALIZED;
+    if (state->failed) return FJ_ERROR_UTF8_ERROR;
     
-    out->impl = &stored_elements[stored_idx];
-    out->doc = nullptr;
+    const uint8_t* p = reinterpret_cast<const uint8_t*>(buf);
     
-    ++iter->current;
-    return true;
+    /* Finish the sequence left open by the previous chunk */
+    if (state->pending_len > 0) {
+        size_t need = utf8_sequence_length(state->pending[0]) - state->pending_len;
+        size_t take = need < len ? need : len;
+        std::memcpy(state->pending + state->pending_len, p, take);
+        state->pending_len = static_cast<uint8_t>(state->pending_len + take);
+        p += take;
+        len -= take;
+        if (take < need) return FJ_SUCCESS;
+        state->failed = !validate_utf8(reinterpret_cast<const char*>(state->pending), state->pending_len);
+        state->pending_len = 0;
+        if (state->failed) return FJ_ERROR_UTF8_ERROR;
+    }
+    
+    /* Hold back a sequence cut by the end of this chunk */
+    size_t keep = 0;
+    for (size_t back = 1; back <= 3 && back <= len; back++) {
+        uint8_t c = p[len - back];
+        if ((c & 0xC0) == 0x80) continue;       /* continuation byte */
+        if (utf8_sequence_length(c) > back) keep = back;
+        break;
+    }
+    
+    if (len - keep > 0 && !validate_utf8(reinterpret_cast<const char*>(p), len - keep)) {
+        state->failed = true;
+        return FJ_ERROR_UTF8_ERROR;
+    }
+    std::memcpy(state->pending, p + len - keep, keep);
+    state->pending_len = static_cast<uint8_t>(keep);
+    return FJ_SUCCESS;
 }
 
-void fj_array_iter_free(fj_array_iter iter) {
-    delete iter;
+fj_error fj_utf8_finish(const fj_utf8_state* state) {
+    if (!state) return FJ_ERROR_UNINITIALIZED;
+    return state->failed || state->pending_len > 0 ? FJ_ERROR_UTF8_ERROR : FJ_SUCCESS;
 }
 
-fj_error fj_object_iter_new(fj_value v, fj_object_iter* iter) {
-    if (!v.impl || !iter) return FJ_ERROR_UNINITIALIZED;
+/* ============================================================================
+ * Line Index Functions
+ * ============================================================================ */
+
+fj_error fj_line_index_build(const char* buf, size_t len, size_t threads, fj_line_index* out) {
+    if ((!buf && len) || !out) return FJ_ERROR_UNINITIALIZED;
+    *out = nullptr;
     
-    auto result = get_element(v)->get_object();
-    if (result.error()) return map_error(result.error());
+    try {
+        /* At least 4MB per thread; below that, spawning costs more than it saves */
+        const size_t min_chunk = size_t(4) << 20;
+        if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+        threads = std::max<size_t>(1, std::min(threads, len / min_chunk));
+        
+        /* Each thread records the starts following the newlines in its chunk */
+        std::vector<std::vector<uint64_t>> parts(threads);
+        std::atomic<bool> failed{false};
+        auto scan = [&](size_t t) {
+            try {
+                size_t from = len / threads * t;
+                size_t to = t + 1 == threads ? len : len / threads * (t + 1);
+                std::vector<uint64_t>& starts = parts[t];
+                starts.reserve((to - from) / 128);
+                if (t == 0 && line_has_content(buf, len, 0)) starts.push_back(0);
+                scan_newlines(buf, from, to, [&](size_t nl) {
+                    if (line_has_content(buf, len, nl + 1)) starts.push_back(nl + 1);
+                });
+            } catch (...) {
+                failed = true;
+            }
+        };
+        {
+            /* Started workers are joined even if starting another one throws */
+            std::vector<std::thread> workers;
+            struct join_all {
+                std::vector<std::thread>& threads;
+                ~join_all() {
+                    for (auto& w : threads) w.join();
+                }
+            } joiner{workers};
+            workers.reserve(threads - 1);
+            for (size_t t = 1; t < threads; t++) workers.emplace_back(scan, t);
+            scan(0);
+        }
+        if (failed) return FJ_ERROR_MEMALLOC;
+        
+        std::unique_ptr<fj_line_index_s> idx(new fj_line_index_s());
+        size_t count = 0;
+        for (auto& part : parts) count += part.size();
+        idx->owned_rel.resize(count);
+        idx->owned_bases.resize((count >> LINE_INDEX_BLOCK_SHIFT) + 1);
+        
+        size_t i = 0;
+        for (auto& part : parts) {
+            for (uint64_t start : part) {
+                uint64_t& base = idx->owned_bases[i >> LINE_INDEX_BLOCK_SHIFT];
+                if ((i & ((size_t(1) << LINE_INDEX_BLOCK_SHIFT) - 1)) == 0) base = start;
+                if (start - base > UINT32_MAX) return FJ_ERROR_CAPACITY;
+                idx->owned_rel[i++] = uint32_t(start - base);
+            }
+            std::vector<uint64_t>().swap(part);
+        }
+        
+        idx->source_size = len;
+        idx->count = count;
+        idx->bases = idx->owned_bases.data();
+        idx->rel = idx->owned_rel.data();
+        *out = idx.release();
+        return FJ_SUCCESS;
+    } catch (...) {
+        return FJ_ERROR_MEMALLOC;
+    }
+}
+
+fj_error fj_line_index_open(const char* data, size_t len, fj_line_index* out) {
+    if (!data || !out) return FJ_ERROR_UNINITIALIZED;
+    *out = nullptr;
+    
+    line_index_header h;
+    if (len < sizeof(h)) return FJ_ERROR_IO_ERROR;
+    std::memcpy(&h, data, sizeof(h));
+    if (std::memcmp(h.magic, LINE_INDEX_MAGIC, sizeof(h.magic)) != 0) return FJ_ERROR_IO_ERROR;
+    
+    uint64_t blocks = (h.count >> LINE_INDEX_BLOCK_SHIFT) + 1;
+    if (h.count > (len - sizeof(h)) / sizeof(uint32_t) ||
+        len != sizeof(h) + blocks * sizeof(uint64_t) + h.count * sizeof(uint32_t)) {
+        return FJ_ERROR_IO_ERROR;
+    }
+    if (reinterpret_cast<uintptr_t>(data) % alignof(uint64_t) != 0) return FJ_ERROR_IO_ERROR;
     
     try {
-        *iter = new fj_object_iter_s(result.value());
+        fj_line_index_s* idx = new fj_line_index_s();
+        idx->source_size = h.source_size;
+        idx->count = h.count;
+        idx->bases = reinterpret_cast<const uint64_t*>(data + sizeof(h));
+        idx->rel = reinterpret_cast<const uint32_t*>(data + sizeof(h) + blocks * sizeof(uint64_t));
+        *out = idx;
         return FJ_SUCCESS;
     } catch (...) {
         return FJ_ERROR_MEMALLOC;
     }
 }
 
-bool fj_object_iter_next(fj_object_iter iter, const char** key, size_t* key_len, fj_value* val) {
-    if (!iter || !key || !key_len || !val) return false;
+fj_error fj_line_index_write(fj_line_index idx, const fj_sink* sink) {
+    if (!idx || !sink || !sink->write) return FJ_ERROR_UNINITIALIZED;
     
-    if (iter->current == iter->end) return false;
+    line_index_header h;
+    std::memcpy(h.magic, LINE_INDEX_MAGIC, sizeof(h.magic));
+    h.source_size = idx->source_size;
+    h.count = idx->count;
+    uint64_t blocks = (idx->count >> LINE_INDEX_BLOCK_SHIFT) + 1;
     
-    auto field = *iter->current;
-    std::string_view k = field.key;
-    *key = k.data();
-    *key_len = k.size();
+    bool ok = sink->write(sink->ctx, reinterpret_cast<const char*>(&h), sizeof(h)) &&
+              sink->write(sink->ctx, reinterpret_cast<const char*>(idx->bases), blocks * sizeof(uint64_t)) &&
+              sink->write(sink->ctx, reinterpret_cast<const char*>(idx->rel), idx->count * sizeof(uint32_t));
+    return ok ? FJ_SUCCESS : FJ_ERROR_IO_ERROR;
+}
+
+size_t fj_line_index_count(fj_line_index idx) {
+    return idx ? size_t(idx->count) : 0;
+}
+
+uint64_t fj_line_index_source_size(fj_line_index idx) {
+    return idx ? idx->source_size : 0;
+}
+
+uint64_t fj_line_index_offset(fj_line_index idx, size_t i) {
+    if (!idx) return 0;
+    if (i >= idx->count) return idx->source_size;
+    return idx->bases[i >> LINE_INDEX_BLOCK_SHIFT] + idx->rel[i];
+}
+
+void fj_line_index_free(fj_line_index idx) {
+    delete idx;
+}
+
+/* ============================================================================
+ * Timestamp Functions
+ * ============================================================================ */
+
+fj_error fj_value_get_timestamp(fj_value v, int64_t* out) {
+    if (!v.impl || !out) return FJ_ERROR_UNINITIALIZED;
     
-    static thread_local dom::element stored_elements[256];
-    static thread_local size_t stored_idx = 0;
-    stored_idx = (stored_idx + 1) % 256;
-    stored_elements[stored_idx] = field.value;
+    internal::tape_ref t = tape_of(get_element(v));
+    if (t.tape_ref_type() != internal::tape_type::STRING) return FJ_ERROR_INCORRECT_TYPE;
+    return parse_timestamp(t.get_c_str(), t.get_string_length(), out);
+}
+
+fj_error fj_array_get_timestamps(fj_value v, fj_path path, int64_t* out, size_t capacity, size_t* count) {
+    if (!v.impl || !count || (!out && capacity)) return FJ_ERROR_UNINITIALIZED;
+    *count = 0;
     
-    val->impl = &stored_elements[stored_idx];
-    val->doc = nullptr;
+    internal::tape_ref arr = tape_of(get_element(v));
+    if (arr.tape_ref_type() != internal::tape_type::START_ARRAY) return FJ_ERROR_INCORRECT_TYPE;
     
-    ++iter->current;
+    const uint64_t document = document_id(v);
+    const size_t end = arr.matching_brace_index() - 1;
+    size_t n = 0;
+    for (size_t idx = arr.json_index + 1; idx < end; idx = internal::tape_ref(arr.doc, idx).after_element()) {
+        if (n == capacity) return FJ_ERROR_CAPACITY;
+        size_t target = idx;
+        if (path) {
+            fj_error err = path_walk(arr.doc, document, idx, path, &target);
+            if (err != FJ_SUCCESS) return err;
+        }
+        internal::tape_ref t(arr.doc, target);
+        if (t.tape_ref_type() != internal::tape_type::STRING) return FJ_ERROR_INCORRECT_TYPE;
+        fj_error err = parse_timestamp(t.get_c_str(), t.get_string_length(), &out[n]);
+        if (err != FJ_SUCCESS) return err;
+        *count = ++n;
+    }
+    return FJ_SUCCESS;
+}
+
+/* ============================================================================
+ * Binary String Functions
+ * ============================================================================ */
+
+fj_error fj_value_get_base64(fj_value v, uint8_t* out, size_t cap, size_t* len) {
+    if (!v.impl || !len || (!out && cap)) return FJ_ERROR_UNINITIALIZED;
+    *len = 0;
+    
+    internal::tape_ref t = tape_of(get_element(v));
+    if (t.tape_ref_type() != internal::tape_type::STRING) return FJ_ERROR_INCORRECT_TYPE;
+    return base64_decode(t.get_c_str(), t.get_string_length(), out, cap, len);
+}
+
+fj_error fj_value_get_hex(fj_value v, uint8_t* out, size_t cap, size_t* len) {
+    if (!v.impl || !len || (!out && cap)) return FJ_ERROR_UNINITIALIZED;
+    *len = 0;
+    
+    internal::tape_ref t = tape_of(get_element(v));
+    if (t.tape_ref_type() != internal::tape_type::STRING) return FJ_ERROR_INCORRECT_TYPE;
+    return hex_decode(t.get_c_str(), t.get_string_length(), out, cap, len);
+}
+
+/* ============================================================================
+ * Metrics Functions
+ * ============================================================================ */
+
+size_t fj_metrics_render(char* buf, size_t cap) {
+#if defined(FASTJSOND_METRICS)
+    std::string text;
+    try {
+        text = metrics_render();
+    } catch (...) {
+        if (buf && cap) buf[0] = '\0';
+        return 0;
+    }
+#else
+    std::string_view text = "# fastjsond built without FASTJSOND_METRICS\n";
+#endif
+    if (buf && cap) {
+        size_t n = text.size() < cap - 1 ? text.size() : cap - 1;
+        std::memcpy(buf, text.data(), n);
+        buf[n] = '\0';
+    }
+    return text.size();
+}
+
+bool fj_metrics_enabled(void) {
+#if defined(FASTJSOND_METRICS)
     return true;
+#else
+    return false;
+#endif
 }
 
-void fj_object_iter_free(fj_object_iter iter) {
-    delete iter;
+void fj_metrics_reset(void) {
+#if defined(FASTJSOND_METRICS)
+    for (metrics_shard& m : metrics_shards) {
+        auto clear = [](std::atomic<uint64_t>& c) { c.store(0, std::memory_order_relaxed); };
+        clear(m.parses);
+        clear(m.parse_bytes);
+        for (auto& row : m.latency) for (auto& c : row) clear(c);
+        for (auto& c : m.latency_sum_ns) clear(c);
+        for (auto& c : m.errors) clear(c);
+        clear(m.streams);
+        clear(m.stream_bytes);
+        clear(m.stream_documents);
+        clear(m.stream_rejected);
+        clear(m.field_cache_hits);
+        clear(m.field_cache_misses);
+    }
+#endif
 }
 
 /* ============================================================================
@@ -520,6 +4538,54 @@ fj_error fj_minify(char* json, size_t len, size_t* out_len) {
     return map_error(err);
 }
 
+fj_error fj_strip_jsonc(const char* json, size_t len, char* out) {
+    if (!json || !out) return FJ_ERROR_UNINITIALIZED;
+    if (out != json) std::memmove(out, json, len);
+    
+    /*
+     * 64 bytes at a time. String literals come from the quote and escape
+     * masks as in simdjson's stage 1; then only closers (for trailing
+     * commas) and slashes outside strings need a look. After a comment,
+     * classification restarts at its end: the comment is skipped with
+     * memchr and any quotes inside it never reach the string mask.
+     */
+    bool in_string = false;
+    uint64_t escape_carry = 0;
+    size_t base = 0;
+    while (base < len) {
+        size_t n = std::min<size_t>(64, len - base);
+        uint64_t valid = n == 64 ? ~uint64_t(0) : (uint64_t(1) << n) - 1;
+        jsonc_block b = jsonc_classify(out + base, n);
+        
+        uint64_t quotes = b.quote & ~jsonc_escaped(b.backslash, escape_carry);
+        uint64_t strings = prefix_xor(quotes) ^ (in_string ? ~uint64_t(0) : 0);
+        
+        uint64_t slashes = b.slash & ~strings & valid;
+        if (slashes) valid = (slashes & (0 - slashes)) - 1;   /* Bytes before the first one */
+        for (uint64_t m = b.closer & ~strings & valid; m; m &= m - 1) {
+            jsonc_trailing_comma(out, base + size_t(__builtin_ctzll(m)));
+        }
+        if (!slashes) {
+            in_string = (strings >> 63) != 0;
+            base += n;
+            continue;
+        }
+        
+        size_t pos = base + size_t(__builtin_ctzll(slashes));
+        size_t end = jsonc_comment_end(out, len, pos);
+        if (end == JSONC_UNCLOSED) return FJ_ERROR_UNCLOSED_COMMENT;
+        if (end == 0) {
+            end = pos + 1;      /* A stray '/' is left to the parser */
+        } else {
+            jsonc_blank(out, pos, end);
+        }
+        in_string = false;
+        escape_carry = 0;
+        base = end;
+    }
+    return FJ_SUCCESS;
+}
+
 fj_error fj_validate(const char* json, size_t len) {
     if (!json) return FJ_ERROR_UNINITIALIZED;
     
@@ -67,6 +67,11 @@ typedef enum fj_error_e {
     FJ_ERROR_SCALAR_DOCUMENT_AS_VALUE, /* Scalar as value */
     FJ_ERROR_OUT_OF_BOUNDS,     /* Out of bounds */
     FJ_ERROR_TRAILING_CONTENT,  /* Trailing content after JSON */
+    FJ_ERROR_INVALID_PATCH,     /* Malformed JSON Patch operation */
+    FJ_ERROR_PATCH_TEST_FAILED, /* JSON Patch test operation failed */
+    FJ_ERROR_INVALID_TIMESTAMP, /* Malformed RFC 3339 timestamp */
+    FJ_ERROR_INVALID_ENCODING,  /* Malformed base64 or hex data */
+    FJ_ERROR_UNCLOSED_COMMENT,  /* Unterminated block comment in JSONC */
     
     FJ_ERROR_UNKNOWN = 255      /* Unknown error */
 } fj_error;
@@ -123,6 +128,45 @@ fj_error fj_parser_parse(fj_parser p, const char* json, size_t len, fj_document*
  */
 fj_error fj_parser_parse_padded(fj_parser p, const char* json, size_t len, fj_document* doc);
 
+/**
+ * Stage breakdown of one parse.
+ */
+typedef struct fj_parse_profile_s {
+    uint64_t stage1_ns;     /* Structural indexing and UTF-8 validation */
+    uint64_t stage2_ns;     /* Tape building, number and string parsing */
+    uint64_t structurals;   /* Structural indexes found by stage 1 */
+    uint64_t string_bytes;  /* String bytes after unescaping, keys included */
+} fj_parse_profile;
+
+/**
+ * Record a fj_parse_profile for every parse of this parser.
+ * Profiled parses run the two stages separately and copy the input first,
+ * so keep profiling off outside of measurements.
+ */
+void fj_parser_set_profiling(fj_parser p, bool enabled);
+
+/**
+ * Profile of the last parse made with profiling on.
+ * A stage that did not run (stage 2 after a stage 1 error) reads 0.
+ * @return FJ_ERROR_UNINITIALIZED if no profiled parse has been made
+ */
+fj_error fj_parser_last_profile(fj_parser p, fj_parse_profile* out);
+
+/**
+ * Return escape-free strings from the input rather than the string buffer.
+ * Stage 2 always unescapes strings into the parser's string buffer; with
+ * this on, fj_value_get_string and object iteration hand out pointers into
+ * json for strings that contain no escapes, so those stay valid after the
+ * document is freed or the parser reused, for as long as json itself.
+ * The first such lookup on a document maps its tokens to input offsets
+ * (one pass over the structural index, 4 bytes per tape word).
+ *
+ * This extends string lifetimes; it does not make parsing or lookups
+ * faster. The map is built once per document, also when several threads
+ * make their first lookup at the same time.
+ */
+void fj_parser_set_borrow_strings(fj_parser p, bool enabled);
+
 /* ============================================================================
  * Document Functions
  * ============================================================================ */
@@ -142,6 +186,27 @@ fj_value fj_document_root(fj_document doc);
  */
 fj_error fj_document_error(fj_document doc);
 
+/**
+ * Shape and memory footprint of a parsed document.
+ */
+typedef struct fj_tape_stats_s {
+    uint64_t tape_words;        /* Tape words used */
+    uint64_t string_bytes;      /* String buffer bytes used */
+    uint64_t counts[8];         /* Values per fj_type, keys excluded */
+    uint64_t keys;              /* Object keys */
+    uint64_t max_depth;         /* Container nesting (0 for a scalar document) */
+    uint64_t largest_array;     /* Elements of the largest array */
+    uint64_t largest_object;    /* Fields of the largest object */
+    uint64_t retained_bytes;    /* Held while the document lives, parser buffers included */
+} fj_tape_stats;
+
+/**
+ * Compute document statistics in one pass over the tape.
+ * retained_bytes is derived from buffer capacities: it includes the
+ * parser's buffers, which the next parse with the same parser reuses.
+ */
+fj_error fj_document_stats(fj_document doc, fj_tape_stats* out);
+
 /**
  * Get error message string.
  * @return Static string, do not free
@@ -200,15 +265,58 @@ fj_error fj_value_get_double(fj_value v, double* out);
 /**
  * Get string value (zero-copy).
  * @param v Value
- * @param out Output string pointer (points into JSON buffer!)
+ * @param out Output string pointer (into the parser's string buffer)
  * @param len Output string length
  * @return Error code
  * 
- * WARNING: Returned string is NOT null-terminated and points into
- * the original JSON buffer. Valid only while document exists.
+ * WARNING: Returned string is unescaped and points into the parser's
+ * string buffer, so it is valid only while the document exists and the
+ * parser is not reused. With fj_parser_set_borrow_strings, strings
+ * without escapes point into the original JSON buffer instead.
  */
 fj_error fj_value_get_string(fj_value v, const char** out, size_t* len);
 
+/**
+ * Get a string as it appears in the input, escapes intact (zero-copy).
+ * The bytes between the quotes, ready to be written back out inside
+ * quotes without re-escaping; escape-free strings need no scan.
+ * @return FJ_ERROR_INCORRECT_TYPE for a non-string, FJ_ERROR_UNINITIALIZED
+ *         when v carries no parsed input (stream records)
+ *
+ * WARNING: Points into the original JSON buffer.
+ */
+fj_error fj_value_get_string_raw(fj_value v, const char** out, size_t* len);
+
+/**
+ * Get signed 64-bit integer from a number or a numeric string ("123").
+ *
+ * A string must hold exactly one JSON integer: optional '-', no leading
+ * zeros, no spaces, no fraction or exponent. Digits are converted eight
+ * at a time, so string-encoded numbers cost about as much as native ones.
+ *
+ * @return Error code (FJ_ERROR_NUMBER_ERROR for a malformed string,
+ *         FJ_ERROR_NUMBER_OUT_OF_RANGE if it does not fit,
+ *         FJ_ERROR_INCORRECT_TYPE for other types)
+ */
+fj_error fj_value_get_int64_lenient(fj_value v, int64_t* out);
+
+/**
+ * Get unsigned 64-bit integer from a number or a numeric string.
+ * Same rules as fj_value_get_int64_lenient; negative values are out of range.
+ */
+fj_error fj_value_get_uint64_lenient(fj_value v, uint64_t* out);
+
+/**
+ * Get double from a number or a numeric string ("19.99", "-1e5").
+ *
+ * A string must hold exactly one JSON number; it is then converted with
+ * simdjson's number parser, rounding exactly like a native number.
+ *
+ * @return Error code (FJ_ERROR_NUMBER_ERROR for a malformed string,
+ *         FJ_ERROR_NUMBER_OUT_OF_RANGE if it overflows a double)
+ */
+fj_error fj_value_get_double_lenient(fj_value v, double* out);
+
 /* ============================================================================
  * Object Access Functions
  * ============================================================================ */
@@ -227,6 +335,68 @@ fj_error fj_value_get_field(fj_value v, const char* key, fj_value* out);
  */
 fj_error fj_value_get_field_len(fj_value v, const char* key, size_t key_len, fj_value* out);
 
+/**
+ * Inline cache for repeated field lookups (zero-initialize before use).
+ *
+ * Remembers where a key was last found: its tape position in that object,
+ * verified with one compare when the same object is searched again, and
+ * its field ordinal, tried first in any other object (e.g. the next
+ * document of a schema-regular stream) before a full scan. A slot last
+ * used on another object or document only costs that scan.
+ */
+typedef struct fj_field_slot_s {
+    uint64_t document;    /* Id of the document last searched (0 = none) */
+    uint32_t object;      /* Tape index of the object last searched */
+    uint32_t key;         /* Tape index of the key found there */
+    uint32_t ordinal;     /* Field ordinal of that key */
+} fj_field_slot;
+
+/**
+ * Get object field by key, checking a field slot cache first.
+ *
+ * The slot is updated on every hit and on a successful scan. Reusing
+ * one slot across documents with identical key order makes the lookup
+ * skip the key comparisons of all preceding fields; repeated lookups in
+ * the same object skip the walk entirely.
+ *
+ * @param v Object value
+ * @param key Field name
+ * @param key_len Field name length
+ * @param slot In/out slot cache
+ * @param out Output value
+ * @return Error code (FJ_ERROR_NO_SUCH_FIELD if not found)
+ */
+fj_error fj_value_get_field_cached(fj_value v, const char* key, size_t key_len,
+                                   fj_field_slot* slot, fj_value* out);
+
+/**
+ * Prepared object key.
+ *
+ * Carries the key length and its first 16 bytes packed into two words
+ * (zero padded, in native byte order) so a lookup can reject a field on
+ * length and a single masked compare. Prepare once with fj_key_init, or
+ * fill in at compile time from bindings; slot is an inline field cache
+ * as in fj_value_get_field_cached.
+ */
+typedef struct fj_key_s {
+    const char* name;     /* Field name (not necessarily null-terminated) */
+    size_t len;           /* Field name length */
+    uint64_t prefix[2];   /* First 16 bytes of name, zero padded */
+    uint64_t mask[2];     /* Byte mask covering the first min(len, 16) bytes */
+    fj_field_slot slot;   /* Lookup cache */
+} fj_key;
+
+/**
+ * Prepare a key for fj_value_get_field_key.
+ */
+void fj_key_init(fj_key* key, const char* name, size_t len);
+
+/**
+ * Get object field by prepared key.
+ * Uses and updates key->slot like fj_value_get_field_cached.
+ */
+fj_error fj_value_get_field_key(fj_value v, fj_key* key, fj_value* out);
+
 /**
  * Check if object has field.
  */
@@ -255,6 +425,36 @@ fj_error fj_value_get_index(fj_value v, size_t idx, fj_value* out);
  */
 fj_error fj_value_array_size(fj_value v, size_t* out);
 
+/**
+ * Dimensions of a rectangular nested array, outermost first.
+ */
+typedef struct fj_shape_s {
+    size_t depth;       /* Array levels (at most 8) */
+    size_t dims[8];     /* Elements per level */
+} fj_shape;
+
+/**
+ * Flatten a rectangular nested array of numbers, e.g. [[lon, lat], ...],
+ * into out in row-major order, in one pass over the tape.
+ *
+ * @param v Array value
+ * @param depth Array levels to flatten (2 for a list of pairs); 0 follows
+ *              the first elements down to the first non-array
+ * @param out Output values (integers are converted)
+ * @param cap Length of out
+ * @param shape Output dimensions, read along the first elements; filled
+ *              even when out is too small, so a NULL/0 call sizes out
+ * @return Error code (FJ_ERROR_INCORRECT_TYPE if not an array, ragged, or
+ *         a leaf is not a number; FJ_ERROR_CAPACITY if out is too small;
+ *         FJ_ERROR_DEPTH_ERROR beyond 8 levels)
+ */
+fj_error fj_array_copy_doubles_nested(fj_value v, size_t depth, double* out, size_t cap, fj_shape* shape);
+
+/**
+ * Same as fj_array_copy_doubles_nested, narrowing each value to float.
+ */
+fj_error fj_array_copy_floats_nested(fj_value v, size_t depth, float* out, size_t cap, fj_shape* shape);
+
 /* ============================================================================
  * Iteration Functions
  * ============================================================================ */
@@ -304,6 +504,607 @@ bool fj_object_iter_next(fj_object_iter iter, const char** key, size_t* key_len,
  */
 void fj_object_iter_free(fj_object_iter iter);
 
+/* ============================================================================
+ * Serialization Functions
+ * ============================================================================ */
+
+/**
+ * Output sink for serializers.
+ * write is called with consecutive chunks of output; returning false aborts
+ * serialization with FJ_ERROR_IO_ERROR.
+ */
+typedef struct fj_sink_s {
+    bool (*write)(void* ctx, const char* data, size_t len);
+    void* ctx;
+} fj_sink;
+
+/**
+ * Write value in canonical form (RFC 8785, JSON Canonicalization Scheme).
+ *
+ * Object keys are sorted by UTF-16 code units, numbers are written as the
+ * shortest round-trip IEEE double in ECMAScript notation, strings use
+ * minimal escaping and no whitespace is emitted. Integers beyond 2^53 are
+ * rounded to the nearest double, as the scheme requires.
+ *
+ * @param v Value
+ * @param sink Output sink (buffered internally)
+ * @return Error code
+ */
+fj_error fj_value_canonicalize(fj_value v, const fj_sink* sink);
+
+/**
+ * Format a double as the shortest text that parses back to the same value,
+ * in ECMAScript notation (1e+21, 0.000001, 1.5e-7).
+ *
+ * @param value Number to format
+ * @param out Output buffer of at least 32 bytes (not null-terminated)
+ * @return Length written, or 0 for NaN and infinities (not valid JSON)
+ */
+size_t fj_format_double(double value, char* out);
+
+/* ============================================================================
+ * Diff Functions
+ * ============================================================================ */
+
+typedef enum fj_diff_op_e {
+    FJ_DIFF_ADD = 0,            /* Member or element only in the new value */
+    FJ_DIFF_REMOVE,             /* Member or element only in the old value */
+    FJ_DIFF_REPLACE             /* Scalar changed, or container kind changed */
+} fj_diff_op;
+
+/**
+ * Change callback for fj_diff_each.
+ * @param ctx User context
+ * @param op Change kind
+ * @param path JSON Pointer of the change (not null-terminated)
+ * @param path_len Path length
+ * @param old_value Old value (impl NULL for FJ_DIFF_ADD)
+ * @param new_value New value (impl NULL for FJ_DIFF_REMOVE)
+ * @return true to continue, false to stop
+ */
+typedef bool (*fj_diff_callback)(void* ctx, fj_diff_op op, const char* path, size_t path_len,
+                                 fj_value old_value, fj_value new_value);
+
+/**
+ * Write the structural diff from a to b as an RFC 6902 JSON Patch array.
+ *
+ * Both tapes are walked together; identical subtrees are skipped by a
+ * word-by-word tape compare that stops at the first difference, so a diff
+ * of mostly-equal documents costs little more than reading them once.
+ * Object members are matched by key (in any order), array elements by
+ * position. Numbers compare by value (1 equals 1.0).
+ *
+ * @param a Old value
+ * @param b New value
+ * @param sink Output sink
+ * @return Error code
+ */
+fj_error fj_diff(fj_value a, fj_value b, const fj_sink* sink);
+
+/**
+ * Report the structural diff from a to b as path-level change events,
+ * in the same order as the operations of fj_diff.
+ */
+fj_error fj_diff_each(fj_value a, fj_value b, fj_diff_callback callback, void* ctx);
+
+/* ============================================================================
+ * Patch Functions
+ * ============================================================================ */
+
+/**
+ * Apply an RFC 6902 JSON Patch to a document and write the result.
+ *
+ * Only the containers along patched paths are rebuilt; every untouched
+ * value, and every run of untouched neighbouring members, is copied from
+ * the original input text, so the cost is the patch size plus roughly a
+ * memcpy of the document. Rebuilt containers are written minified. The
+ * document itself is not modified, and nothing is written on error.
+ *
+ * The input passed to fj_parser_parse must still be alive and unchanged.
+ *
+ * @param doc Document to patch
+ * @param patch JSON Patch text (an array of operations)
+ * @param patch_len Patch length
+ * @param sink Output sink
+ * @return FJ_SUCCESS, FJ_ERROR_INVALID_PATCH for a malformed operation,
+ *         FJ_ERROR_PATCH_TEST_FAILED when a test operation fails,
+ *         FJ_ERROR_NO_SUCH_FIELD / FJ_ERROR_INDEX_OUT_OF_BOUNDS for a
+ *         missing target, or a parse error from the patch text
+ */
+fj_error fj_apply_patch(fj_document doc, const char* patch, size_t patch_len, const fj_sink* sink);
+
+/**
+ * Apply an RFC 7396 JSON Merge Patch to a document and write the result,
+ * with the same raw-copy strategy as fj_apply_patch.
+ */
+fj_error fj_apply_merge_patch(fj_document doc, const char* patch, size_t patch_len, const fj_sink* sink);
+
+/* ============================================================================
+ * Mutable Document Functions
+ * ============================================================================ */
+
+typedef struct fj_mutable_s* fj_mutable;
+
+/**
+ * Create an editable overlay over a parsed document.
+ *
+ * Edits are recorded beside the immutable tape: only the containers on
+ * edited paths are rebuilt as child lists, everything else is read from
+ * the tape and, when serializing, copied from the original input. Edits
+ * cost O(path depth + siblings on the path); serialization merges the
+ * two. The document and its input must outlive the overlay.
+ *
+ * @param doc Document to edit (not modified)
+ * @param out Receives the overlay handle
+ * @return Error code
+ */
+fj_error fj_mutable_new(fj_document doc, fj_mutable* out);
+
+/**
+ * Free an overlay and every value it owns.
+ */
+void fj_mutable_free(fj_mutable m);
+
+/**
+ * Set the value at a JSON Pointer: create or overwrite an object member,
+ * overwrite an array element, or append with "-". An empty path replaces
+ * the root.
+ * @param json Value as JSON text
+ * @return Error code (FJ_ERROR_NO_SUCH_FIELD / FJ_ERROR_INDEX_OUT_OF_BOUNDS
+ *         when the parent does not exist)
+ */
+fj_error fj_mutable_set(fj_mutable m, const char* path, size_t path_len,
+                        const char* json, size_t json_len);
+
+/**
+ * Insert a value at a JSON Pointer (RFC 6902 add): array elements shift
+ * right, object members are set.
+ */
+fj_error fj_mutable_insert(fj_mutable m, const char* path, size_t path_len,
+                           const char* json, size_t json_len);
+
+/**
+ * Delete the member or element at a JSON Pointer.
+ */
+fj_error fj_mutable_remove(fj_mutable m, const char* path, size_t path_len);
+
+/**
+ * Read the current value at a JSON Pointer.
+ *
+ * Unedited values are read straight from the tape; an edited container
+ * is materialized into a value owned by the overlay, once per edit below
+ * it. Materialized values carry no document (doc is null).
+ *
+ * Like the values returned by lookups on a document, out is a handle
+ * held in a per-thread ring: it may be reused once 256 further lookups
+ * have run on the calling thread, and never outlives the overlay, so
+ * copy out what must be kept.
+ * @param out Receives the value
+ * @return Error code
+ */
+fj_error fj_mutable_get(fj_mutable m, const char* path, size_t path_len, fj_value* out);
+
+/**
+ * Write the edited document, copying unedited regions from the input.
+ */
+fj_error fj_mutable_serialize(fj_mutable m, const fj_sink* sink);
+
+/* ============================================================================
+ * Streaming Functions
+ * ============================================================================ */
+
+/* Opaque stream handle over concatenated or newline-delimited documents */
+typedef struct fj_stream_s* fj_stream;
+
+/**
+ * Start parsing a stream of JSON documents (NDJSON, or whitespace-separated).
+ *
+ * Input is copied once into an internal padded buffer. The parser is busy
+ * until the stream is freed and must outlive it.
+ *
+ * @param p Parser instance
+ * @param json Documents buffer
+ * @param len Length of buffer
+ * @param batch_size Bytes indexed per batch, must exceed the largest
+ *                   document (0 = default 1MB)
+ * @param stream Output stream handle
+ * @return Error code
+ */
+fj_error fj_parser_parse_many(fj_parser p, const char* json, size_t len, size_t batch_size,
+                              fj_stream* stream);
+
+/**
+ * Start parsing a stream of JSON documents without copying.
+ * The buffer must have fj_required_padding() readable bytes after len and
+ * must remain valid until the stream is freed.
+ */
+fj_error fj_parser_parse_many_padded(fj_parser p, const char* json, size_t len, size_t batch_size,
+                                     fj_stream* stream);
+
+/**
+ * Get next document root.
+ * @param s Stream
+ * @param out Output value (valid until the next call)
+ * @param err Output error code, may be NULL (FJ_SUCCESS at end of stream)
+ * @return true if document available, false at end or on error
+ */
+bool fj_stream_next(fj_stream s, fj_value* out, fj_error* err);
+
+/**
+ * Get byte offset of the current document in the input.
+ */
+size_t fj_stream_current_offset(fj_stream s);
+
+/**
+ * Get number of unparsed bytes left at the end of the input (an incomplete
+ * final document). Only meaningful once fj_stream_next returned false.
+ */
+size_t fj_stream_truncated_bytes(fj_stream s);
+
+/* A record skipped by a tolerant stream */
+typedef struct fj_rejected_record_s {
+    size_t offset;              /* Byte offset in the input */
+    size_t length;              /* Length up to the end of its line */
+    const char* text;           /* Record bytes, valid while the stream lives */
+    fj_error error;             /* Why it was rejected */
+} fj_rejected_record;
+
+/* Called for each rejected record (the record is only valid during the call) */
+typedef void (*fj_record_error_callback)(void* ctx, const fj_rejected_record* record);
+
+/**
+ * Make a newline-delimited stream skip malformed records instead of ending.
+ *
+ * A record that fails to parse is rejected through the end of its line and
+ * iteration resumes on the next line. Other records in the same batch keep
+ * their stage 1 index, so an error costs the bad line plus a short search;
+ * only failures that poison a whole batch (invalid UTF-8, an unbalanced
+ * quote) re-index, in a window sized to the distance between errors. An
+ * unterminated last line that fails is left as truncated bytes rather than
+ * rejected, so a chunked reader can carry it over.
+ *
+ * Must be called before the first fj_stream_next.
+ *
+ * @param s Stream
+ * @param callback Called for each rejected record, or NULL to queue them
+ *                 for fj_stream_next_rejected
+ * @param ctx Passed to callback
+ * @return Error code (FJ_ERROR_OUT_OF_ORDER_ITERATION once iteration began)
+ */
+fj_error fj_stream_set_tolerant(fj_stream s, fj_record_error_callback callback, void* ctx);
+
+/**
+ * Get number of records rejected so far by a tolerant stream.
+ */
+size_t fj_stream_rejected_count(fj_stream s);
+
+/**
+ * Pop the oldest queued rejected record (tolerant stream without callback).
+ * @return true if a record was available
+ */
+bool fj_stream_next_rejected(fj_stream s, fj_rejected_record* out);
+
+/**
+ * Free stream.
+ */
+void fj_stream_free(fj_stream s);
+
+/* ============================================================================
+ * Path Functions
+ * ============================================================================ */
+
+/* Opaque compiled path handle */
+typedef struct fj_path_s* fj_path;
+
+/**
+ * Compile a path for repeated evaluation.
+ *
+ * Accepts a JSON Pointer ("/metrics/latency_ms", "/items/0") or a dotted
+ * path (".metrics.latency_ms", "items[0].id"); "" selects the root. Each
+ * object step keeps its own field slot cache (see fj_value_get_field_cached),
+ * so on documents of the same shape each step compares only the key at
+ * the remembered position, and re-evaluating on the same document is one
+ * check per step. A path is not thread-safe.
+ *
+ * @param path Path text
+ * @param len Path length
+ * @param out Output path handle
+ * @return Error code (FJ_ERROR_INVALID_JSON_POINTER if malformed)
+ */
+fj_error fj_path_compile(const char* path, size_t len, fj_path* out);
+
+/**
+ * Free compiled path.
+ */
+void fj_path_free(fj_path path);
+
+/**
+ * Evaluate compiled path.
+ * @param v Starting value
+ * @param path Compiled path
+ * @param out Output value
+ * @return Error code (FJ_ERROR_NO_SUCH_FIELD, FJ_ERROR_INDEX_OUT_OF_BOUNDS or
+ *         FJ_ERROR_INCORRECT_TYPE if a step does not resolve)
+ */
+fj_error fj_value_at_path(fj_value v, fj_path path, fj_value* out);
+
+/* ============================================================================
+ * Aggregation Functions
+ * ============================================================================ */
+
+/* Opaque aggregator handle */
+typedef struct fj_agg_s* fj_agg;
+
+/* Aggregate of one group */
+typedef struct fj_agg_stats_s {
+    uint64_t count;           /* Documents where the value path resolved */
+    uint64_t numeric_count;   /* Of those, numeric values */
+    double sum;               /* Sum of numeric values */
+    double min;               /* Minimum numeric value (0 if none) */
+    double max;               /* Maximum numeric value (0 if none) */
+    double mean;              /* sum / numeric_count (0 if none) */
+    uint64_t distinct;        /* Approximate distinct scalar values (HyperLogLog, ~3% error) */
+} fj_agg_stats;
+
+/**
+ * Create an aggregator over a value path, optionally grouped by a string.
+ *
+ * Documents are folded in directly from the tape, without materializing
+ * values. Groups are kept in first-seen order.
+ *
+ * @param value_path Path of the aggregated value (see fj_path_compile)
+ * @param value_path_len Length of value_path
+ * @param group_path Path of the string group key, or NULL for a single group
+ * @param group_path_len Length of group_path
+ * @param out Output aggregator handle
+ * @return Error code
+ */
+fj_error fj_agg_new(const char* value_path, size_t value_path_len,
+                    const char* group_path, size_t group_path_len, fj_agg* out);
+
+/**
+ * Free aggregator.
+ */
+void fj_agg_free(fj_agg agg);
+
+/**
+ * Drop all groups and counters.
+ */
+void fj_agg_reset(fj_agg agg);
+
+/**
+ * Fold one document into the aggregate.
+ */
+fj_error fj_agg_add(fj_agg agg, fj_value v);
+
+/**
+ * Fold every remaining document of a stream into the aggregate.
+ * @return Error code of the stream (FJ_SUCCESS if it ended cleanly)
+ */
+fj_error fj_agg_consume(fj_agg agg, fj_stream stream);
+
+/**
+ * Get number of groups.
+ */
+size_t fj_agg_group_count(fj_agg agg);
+
+/**
+ * Get number of documents skipped because the value path did not resolve,
+ * or the group key was missing or not a string.
+ */
+uint64_t fj_agg_skipped(fj_agg agg);
+
+/**
+ * Get group result.
+ * @param agg Aggregator
+ * @param idx Group index (0 to fj_agg_group_count - 1)
+ * @param key Output group key (owned by aggregator, valid until reset/free)
+ * @param key_len Output group key length
+ * @param stats Output statistics
+ * @return Error code (FJ_ERROR_INDEX_OUT_OF_BOUNDS if invalid)
+ */
+fj_error fj_agg_group(fj_agg agg, size_t idx, const char** key, size_t* key_len,
+                      fj_agg_stats* stats);
+
+/* ============================================================================
+ * UTF-8 Functions
+ * ============================================================================ */
+
+/**
+ * Validate UTF-8 text (any bytes, not just JSON) with the runtime-selected
+ * SIMD kernel.
+ * @return FJ_SUCCESS, or FJ_ERROR_UTF8_ERROR
+ */
+fj_error fj_validate_utf8(const char* buf, size_t len);
+
+/**
+ * State of a chunked UTF-8 validation. A sequence cut by a chunk boundary
+ * is carried over to the next chunk, so data can be checked as it streams.
+ * Initialize with fj_utf8_init; the fields are private.
+ */
+typedef struct fj_utf8_state_s {
+    uint8_t pending[4];         /* Bytes of an unfinished sequence */
+    uint8_t pending_len;
+    bool failed;
+} fj_utf8_state;
+
+/**
+ * Reset a chunked validation.
+ */
+void fj_utf8_init(fj_utf8_state* state);
+
+/**
+ * Validate the next chunk.
+ * @return FJ_SUCCESS so far, or FJ_ERROR_UTF8_ERROR (sticky)
+ */
+fj_error fj_utf8_update(fj_utf8_state* state, const char* buf, size_t len);
+
+/**
+ * End a chunked validation.
+ * @return FJ_ERROR_UTF8_ERROR if any chunk failed or the input ends
+ *         inside a sequence
+ */
+fj_error fj_utf8_finish(const fj_utf8_state* state);
+
+/* ============================================================================
+ * Line Index Functions
+ * ============================================================================ */
+
+/* Opaque record offset index of an NDJSON buffer */
+typedef struct fj_line_index_s* fj_line_index;
+
+/**
+ * Index the start of every record (a line holding more than JSON
+ * whitespace) of an NDJSON buffer.
+ *
+ * Newlines are found with a vector compare over 16-32 bytes per step,
+ * with the buffer split across threads. Offsets are stored compactly:
+ * one 64-bit base per 256 records plus a 32-bit delta per record.
+ *
+ * @param buf NDJSON buffer (e.g. a mapped file)
+ * @param len Buffer length
+ * @param threads Worker threads (0 = hardware concurrency); buffers are
+ *                split in chunks of at least 4MB
+ * @param out Output index handle
+ * @return Error code (FJ_ERROR_CAPACITY if 256 records span over 4GB)
+ */
+fj_error fj_line_index_build(const char* buf, size_t len, size_t threads, fj_line_index* out);
+
+/**
+ * Use a serialized index (see fj_line_index_write) in place, without
+ * copying. data must be 8-byte aligned (a mapped file is) and must
+ * outlive the index.
+ * @return Error code (FJ_ERROR_IO_ERROR if data is not a valid index)
+ */
+fj_error fj_line_index_open(const char* data, size_t len, fj_line_index* out);
+
+/**
+ * Serialize an index (host byte order) for fj_line_index_open.
+ * @return Error code (FJ_ERROR_IO_ERROR if the sink aborted)
+ */
+fj_error fj_line_index_write(fj_line_index idx, const fj_sink* sink);
+
+/**
+ * Get number of records.
+ */
+size_t fj_line_index_count(fj_line_index idx);
+
+/**
+ * Get length of the buffer the index was built from.
+ */
+uint64_t fj_line_index_source_size(fj_line_index idx);
+
+/**
+ * Get offset of record i; i == count gives the source size, so record i
+ * spans [offset(i), offset(i + 1)) including its newline and any blank
+ * lines after it.
+ */
+uint64_t fj_line_index_offset(fj_line_index idx, size_t i);
+
+/**
+ * Free index.
+ */
+void fj_line_index_free(fj_line_index idx);
+
+/* ============================================================================
+ * Timestamp Functions
+ * ============================================================================ */
+
+/**
+ * Get an RFC 3339 timestamp string as nanoseconds since the Unix epoch.
+ *
+ * Accepts "YYYY-MM-DDTHH:MM:SS", an optional fraction (digits beyond
+ * nanoseconds are truncated) and "Z" or a "+HH:MM"/"-HH:MM" offset; 't'
+ * or ' ' may separate date and time. The common fixed-width layout is
+ * validated and decoded a word at a time. A leap second (:60) rolls into
+ * the next minute.
+ *
+ * @param v String value
+ * @param out Output nanoseconds (UTC)
+ * @return Error code (FJ_ERROR_INVALID_TIMESTAMP if malformed,
+ *         FJ_ERROR_NUMBER_OUT_OF_RANGE outside 1677-09-21..2262-04-11,
+ *         FJ_ERROR_INCORRECT_TYPE if not a string)
+ */
+fj_error fj_value_get_timestamp(fj_value v, int64_t* out);
+
+/**
+ * Convert a column of timestamps in one call.
+ *
+ * Reads every element of an array, or the value at path within every
+ * element (e.g. "/timestamp" for an array of log records), straight from
+ * the tape.
+ *
+ * @param v Array value
+ * @param path Compiled path applied to each element, or NULL
+ * @param out Output nanoseconds, one per element
+ * @param capacity Length of out
+ * @param count Output number converted; on error, the index of the
+ *              element that failed
+ * @return Error code (as fj_value_get_timestamp, path errors as
+ *         fj_value_at_path, FJ_ERROR_CAPACITY if the array is longer
+ *         than capacity)
+ */
+fj_error fj_array_get_timestamps(fj_value v, fj_path path, int64_t* out, size_t capacity, size_t* count);
+
+/* ============================================================================
+ * Binary String Functions
+ * ============================================================================ */
+
+/**
+ * Decode a base64 string value into a caller buffer.
+ *
+ * Reads straight from the document's string buffer. Builds with AVX2
+ * decode 32 characters per step; every other target, arm64 included,
+ * runs the scalar table loop. Accepts the standard and URL-safe
+ * alphabets, with or without '=' padding; whitespace is not allowed.
+ *
+ * @param v String value
+ * @param out Output buffer (may be NULL when cap is 0)
+ * @param cap Output buffer size
+ * @param len Output decoded size, set also on FJ_ERROR_CAPACITY so that a
+ *            call with cap 0 can size the buffer
+ * @return Error code (FJ_ERROR_INVALID_ENCODING if malformed,
+ *         FJ_ERROR_CAPACITY if out is too small,
+ *         FJ_ERROR_INCORRECT_TYPE if not a string)
+ */
+fj_error fj_value_get_base64(fj_value v, uint8_t* out, size_t cap, size_t* len);
+
+/**
+ * Decode a hex string value (either case) into a caller buffer.
+ * Same contract as fj_value_get_base64.
+ */
+fj_error fj_value_get_hex(fj_value v, uint8_t* out, size_t cap, size_t* len);
+
+/* ============================================================================
+ * Metrics Functions
+ * ============================================================================ */
+
+/**
+ * Render process-wide metrics in Prometheus text exposition format.
+ *
+ * Covers parse count, bytes and latency (histogram by input size class),
+ * errors by code, stream documents and rejected records, and field slot
+ * cache hits. Counters are only collected when the library is built with
+ * -DFASTJSOND_METRICS (make METRICS=1); otherwise the output is a single
+ * comment line and the hooks compile away.
+ *
+ * @param buf Output buffer, always NUL-terminated if cap > 0 (may be NULL)
+ * @param cap Buffer size
+ * @return Length of the full text, excluding the NUL; if >= cap the output
+ *         was truncated (call again with a larger buffer)
+ */
+size_t fj_metrics_render(char* buf, size_t cap);
+
+/**
+ * Whether metrics are compiled in.
+ */
+bool fj_metrics_enabled(void);
+
+/**
+ * Zero all counters (for tests; Prometheus expects counters to only grow).
+ */
+void fj_metrics_reset(void);
+
 /* ============================================================================
  * Utility Functions  
  * ============================================================================ */
@@ -329,6 +1130,20 @@ const char* fj_active_implementation(void);
  */
 fj_error fj_minify(char* json, size_t len, size_t* out_len);
 
+/**
+ * Strip JSONC down to JSON: // and block comments and trailing commas
+ * (before ] or }) become spaces, string literals are left untouched.
+ * Line breaks are kept, so the output has the same length, offsets and
+ * line numbers as the input. Other syntax errors are left to the parser.
+ * @param json Input
+ * @param len Input length
+ * @param out Output of len bytes; may be json itself (in place) or a
+ *            buffer with fj_required_padding() spare bytes for
+ *            fj_parser_parse_padded
+ * @return Error code (FJ_ERROR_UNCLOSED_COMMENT for an unterminated block comment)
+ */
+fj_error fj_strip_jsonc(const char* json, size_t len, char* out);
+
 /**
  * Validate JSON without full parse.
  * Faster than full parse if you only need to check validity.